@@ -17,6 +17,12 @@
 import bb.cascades 1.4
 
 Page {
+    // The tuning indicator's colours, far off, off, in tune and unlit
+    property variant bigDiffColor: Color.create("#ffdc322f")
+    property variant smallDiffColor: Color.create("#ffb58900")
+    property variant inTuneColor: Color.create("#ff2aa198")
+    property variant neutralColor: Color.create("#ffeee8d5")
+
     Container {
         background: Color.create("#fffdf6e3")
 
@@ -29,7 +35,7 @@ Page {
             Label {
                 id: noteLabel
                 objectName: "noteLabel"
-                text: ""
+                text: tuner.note
                 verticalAlignment: VerticalAlignment.Center
                 horizontalAlignment: HorizontalAlignment.Center
                 
@@ -43,7 +49,7 @@ Page {
             Label {
                 id: tuneCentsOffsetLabel
                 objectName: "tuneCentsOffsetLabel"
-                text: ""
+                text: tuner.cents
                 verticalAlignment: VerticalAlignment.Center
                 horizontalAlignment: HorizontalAlignment.Center
                 
@@ -54,23 +60,71 @@ Page {
                 }
             }
             
+            Label {
+                id: vibratoLabel
+                objectName: "vibratoLabel"
+                text: tuner.vibrato
+                visible: tuner.vibrato != ""
+                verticalAlignment: VerticalAlignment.Center
+                horizontalAlignment: HorizontalAlignment.Center
+                
+                textStyle {
+                    base: SystemDefaults.TextStyles.SmallText
+                    color: Color.create("#ff657b83")
+                    textAlign: TextAlign.Center
+                }
+            }
+            
             Container {
+                id: tuneOffsetIndicator
+                objectName: "tuneOffsetIndicator"
                 horizontalAlignment: HorizontalAlignment.Center
                 verticalAlignment: VerticalAlignment.Center 
+                layout: StackLayout {
+                    orientation: LayoutOrientation.LeftToRight
+                }
                 
+                // One circle per step of tuner.indicator, from far flat to far sharp
                 Label {
-                    id: tuneOffsetLabel
-                    objectName: "tuneOffsetLabel"
-                    text: "<span>n</span> <span>n</span> <span>n</span> <span>n</span> <span>n</span>"
-                    textFormat: TextFormat.Html
-                    
+                    text: "n"
                     textStyle {
                         base: SystemDefaults.TextStyles.PrimaryText
                         fontFamily: "Webdings"
-                        color: Color.create("#ffeee8d5")
-                    } 
+                        color: tuner.indicator == -2 ? bigDiffColor : neutralColor
+                    }
+                }
+                Label {
+                    text: "n"
+                    textStyle {
+                        base: SystemDefaults.TextStyles.PrimaryText
+                        fontFamily: "Webdings"
+                        color: tuner.indicator == -1 ? smallDiffColor : neutralColor
+                    }
+                }
+                Label {
+                    text: "n"
+                    textStyle {
+                        base: SystemDefaults.TextStyles.PrimaryText
+                        fontFamily: "Webdings"
+                        color: tuner.indicator == 0 ? inTuneColor : neutralColor
+                    }
+                }
+                Label {
+                    text: "n"
+                    textStyle {
+                        base: SystemDefaults.TextStyles.PrimaryText
+                        fontFamily: "Webdings"
+                        color: tuner.indicator == 1 ? smallDiffColor : neutralColor
+                    }
+                }
+                Label {
+                    text: "n"
+                    textStyle {
+                        base: SystemDefaults.TextStyles.PrimaryText
+                        fontFamily: "Webdings"
+                        color: tuner.indicator == 2 ? bigDiffColor : neutralColor
+                    }
                 }
-                
             }
         }    
     }
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.hpp"
+
+#include <QMap>
+
+double benchMinSeconds = BENCH_MIN_SECONDS;
+
+static const char* kindNames[] = { "time", "rate", "accuracy" };
+
+void BenchReport::add(const QByteArray& name, double value, const char* unit, BenchMetricKind kind) {
+    BenchResult result;
+    result.name = name;
+    result.value = value;
+    result.unit = unit;
+    result.kind = kind;
+    results.append(result);
+}
+
+void BenchReport::print(FILE* out) const {
+    for (int i = 0; i < results.size(); i++)
+        fprintf(out, "%-40s %14.3f %s\n", results[i].name.constData(), results[i].value, results[i].unit.constData());
+}
+
+bool BenchReport::writeBaseline(const char* path) const {
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+        return false;
+    for (int i = 0; i < results.size(); i++)
+        fprintf(file, "%s %.6g %s %s\n", results[i].name.constData(), results[i].value,
+                results[i].unit.constData(), kindNames[results[i].kind]);
+    return fclose(file) == 0;
+}
+
+int BenchReport::compare(const char* baselinePath, FILE* out) const {
+    FILE* file = fopen(baselinePath, "r");
+    if (file == NULL) {
+        fprintf(out, "Cannot read baseline %s\n", baselinePath);
+        return -1;
+    }
+    QMap<QByteArray, double> baseline;
+    char name[256];
+    char unit[64];
+    char kind[64];
+    double value;
+    while (fscanf(file, "%255s %lf %63s %63s", name, &value, unit, kind) == 4)
+        baseline.insert(name, value);
+    fclose(file);
+
+    int regressions = 0;
+    for (int i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        if (!baseline.contains(result.name))
+            continue;
+
+        double before = baseline.value(result.name);
+        bool worse;
+        switch (result.kind) {
+        case TimeMetric:
+            worse = result.value > before*(1 + BENCH_TIME_TOLERANCE);
+            break;
+        case RateMetric:
+            worse = result.value < before*(1 - BENCH_TIME_TOLERANCE);
+            break;
+        case AccuracyMetric:
+        default:
+            worse = result.value > before + BENCH_ACCURACY_TOLERANCE;
+            break;
+        }
+        if (worse) {
+            fprintf(out, "REGRESSION %-40s %.3f -> %.3f %s\n", result.name.constData(), before, result.value,
+                    result.unit.constData());
+            regressions++;
+        }
+    }
+    return regressions;
+}
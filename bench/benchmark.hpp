@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef Benchmark_HPP_
+#define Benchmark_HPP_
+
+#include <QByteArray>
+#include <QList>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include "fftscalar.hpp"
+#include "peakestimator.hpp"
+#include "pitchdetector.hpp"
+
+// Default for the shortest time a benchmark is repeated for, the mean over all runs is
+// reported
+#define BENCH_MIN_SECONDS 0.2
+// Relative slowdown of a timing that counts as a regression
+#define BENCH_TIME_TOLERANCE 0.15
+// Absolute increase of an accuracy figure (cents, rates) that counts as a regression
+#define BENCH_ACCURACY_TOLERANCE 0.5
+
+// Seconds since an arbitrary point, for timing
+inline double benchClock() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return double(t.tv_sec) + double(t.tv_nsec)/1000000000;
+}
+
+// Shortest time each benchmark runs for, set from the command line
+extern double benchMinSeconds;
+
+// Runs f() once to warm up, then repeatedly for at least benchMinSeconds and returns
+// the mean seconds per run
+template <typename F>
+double timeRuns(F& f) {
+    f();
+    size_t runs = 0;
+    double start = benchClock();
+    double elapsed;
+    do {
+        f();
+        runs++;
+        elapsed = benchClock() - start;
+    } while (elapsed < benchMinSeconds);
+    return elapsed/runs;
+}
+
+enum BenchMetricKind {
+    // Time per something, lower is better and compared relatively
+    TimeMetric,
+    // Readings or samples per second, higher is better and compared relatively
+    RateMetric,
+    // Errors in cents or false reading rates, lower is better and compared absolutely
+    AccuracyMetric
+};
+
+struct BenchResult {
+    QByteArray name;
+    double value;
+    QByteArray unit;
+    BenchMetricKind kind;
+};
+
+/*
+ * Collects benchmark results and keeps them as a baseline. The baseline is a plain text
+ * file with one "name value unit kind" line per result, so it can be diffed, plotted
+ * or checked into a branch next to the code it was measured on.
+ */
+class BenchReport {
+public:
+    void add(const QByteArray& name, double value, const char* unit, BenchMetricKind kind);
+
+    void print(FILE* out) const;
+    bool writeBaseline(const char* path) const;
+    // Prints every result that got worse than the baseline by more than the tolerance
+    // and returns how many did. Results missing from either side are ignored.
+    int compare(const char* baselinePath, FILE* out) const;
+
+private:
+    QList<BenchResult> results;
+};
+
+// Checks every windowing kernel the CPU supports against the scalar reference, at odd
+// lengths and unaligned offsets. Returns the number of kernels that failed.
+int checkKernels(FILE* out);
+// Times each stage of the FFT peak path on its own at one FFT size, the windowing, FFT
+// and peak search in every FftScalarType
+void benchStages(BenchReport* report, size_t fftSize);
+// Accuracy of every PeakEstimator on rectangular and Hann windowed tones at one FFT
+// size, and the time each takes per call
+void benchEstimators(BenchReport* report, size_t fftSize);
+// Runs whole readings through a detector on tones, a chord and noise. The scalar type
+// and the estimator only matter to the FFT peak detector.
+void benchPipeline(BenchReport* report, PitchDetectorType detector, FftScalarType scalar = FloatFftScalar,
+        PeakEstimator estimator = PEAK_DEFAULT_ESTIMATOR);
+
+#endif /* Benchmark_HPP_ */
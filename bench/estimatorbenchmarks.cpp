@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "benchmark.hpp"
+
+#include <math.h>
+#include <string.h>
+#include "fftplancache.hpp"
+#include "peakestimator.hpp"
+#include "signals.hpp"
+#include "spectralpeaks.hpp"
+#include "windowing.hpp"
+
+#define ESTIMATOR_SAMPLE_RATE 44100
+// Detunings per note, spread evenly over a bin
+#define ESTIMATOR_OFFSETS 16
+#define ESTIMATOR_INNER_CALLS 1000
+
+namespace {
+
+// Guitar strings up to a high one, as in the pipeline benchmarks
+const int estimatorNotes[] = { 40, 45, 50, 55, 59, 64, 69, 76, 84 };
+
+struct EstimatorStage {
+    PeakEstimator estimator;
+    const kiss_fft_cpx* bins;
+    float sink;
+
+    void operator()() {
+        float sum = 0;
+        for (int i = 0; i < ESTIMATOR_INNER_CALLS; i++)
+            sum += peakOffset(estimator, HannWindow, bins);
+        sink = sum;
+    }
+};
+
+}
+
+void benchEstimators(BenchReport* report, size_t fftSize) {
+    short* samples = new short[fftSize];
+    const FftPlan* plan = FftPlanCache::shared()->plan(fftSize);
+    FftWorkspace workspace;
+    workspace.reserve(fftSize);
+    SpectralPeakPicker picker(fftSize/2 + 1);
+    WindowType windows[] = { RectangularWindow, HannWindow };
+    const char* windowNames[] = { "rectangular", "hann" };
+    double binWidth = double(ESTIMATOR_SAMPLE_RATE)/fftSize;
+    int noteCount = int(sizeof(estimatorNotes)/sizeof(estimatorNotes[0]));
+    kiss_fft_cpx bins[3];
+
+    for (int w = 0; w < 2; w++) {
+        const float* window = WindowCache::shared()->table(windows[w], fftSize);
+        double maxError[PeakEstimatorCount];
+        double totalError[PeakEstimatorCount];
+        memset(maxError, 0, sizeof(maxError));
+        memset(totalError, 0, sizeof(totalError));
+        int count = 0;
+
+        // Plucked tones with their harmonics and a little noise, placed all over a bin
+        for (int n = 0; n < noteCount; n++) {
+            for (int o = 0; o < ESTIMATOR_OFFSETS; o++) {
+                double centre = floor(midiToFreq(estimatorNotes[n])/binWidth);
+                double bin = centre + (o + 0.5)/ESTIMATOR_OFFSETS - 0.5;
+                memset(samples, 0, sizeof(short)*fftSize);
+                addTone(samples, fftSize, ESTIMATOR_SAMPLE_RATE, bin*binWidth, 8000, 0.1*o);
+                addNoise(samples, fftSize, 50, n*ESTIMATOR_OFFSETS + o + 1);
+                windowSamplesScalar(samples, window, workspace.timeData(), fftSize);
+                plan->forward(workspace.timeData(), workspace.freqData(), workspace.scratch());
+
+                SpectralPeak peak;
+                if (picker.find(workspace.freqData(), size_t(centre) - 2, size_t(centre) + 3, &peak, 1) == 0)
+                    continue;
+                memcpy(bins, &workspace.freqData()[peak.bin - 1], sizeof(bins));
+                for (int e = 0; e < PeakEstimatorCount; e++) {
+                    double error = fabs(peak.bin + peakOffset(PeakEstimator(e), windows[w], bins) - bin);
+                    totalError[e] += error;
+                    maxError[e] = qMax(maxError[e], error);
+                }
+                count++;
+            }
+        }
+
+        // In thousandths of a bin, so that the accuracy tolerance means something
+        QByteArray prefix = "estimator." + QByteArray::number(int(fftSize)) + "." + windowNames[w] + ".";
+        for (int e = 0; e < PeakEstimatorCount; e++) {
+            QByteArray name = prefix + peakEstimatorName(PeakEstimator(e)) + ".";
+            report->add(name + "mean-error", count > 0 ? 1000*totalError[e]/count : 0, "mbins", AccuracyMetric);
+            report->add(name + "max-error", 1000*maxError[e], "mbins", AccuracyMetric);
+        }
+    }
+
+    // The cost per call on the bins of the last tone
+    double perCall = 1000000000.0/ESTIMATOR_INNER_CALLS;
+    for (int e = 0; e < PeakEstimatorCount; e++) {
+        EstimatorStage stage = { PeakEstimator(e), bins, 0 };
+        report->add(QByteArray("estimator.") + peakEstimatorName(PeakEstimator(e)), timeRuns(stage)*perCall,
+                "ns/call", TimeMetric);
+    }
+
+    delete[] samples;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "benchmark.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include "windowing.hpp"
+
+// Lengths up to this are all checked, which covers every tail of every vector width
+#define CHECK_MAX_SHORT_LENGTH 67
+// Offsets in elements from an aligned buffer that inputs and outputs are checked at
+#define CHECK_MAX_OFFSET 3
+// Elements past the end that must not be written
+#define CHECK_GUARD 16
+#define CHECK_MAX_KERNELS 8
+
+namespace {
+
+const size_t longLengths[] = { 1023, 4096, 4099 };
+
+// The lengths to check, the short ones and then the long ones
+size_t checkLength(size_t index) {
+    return index <= CHECK_MAX_SHORT_LENGTH ? index : longLengths[index - CHECK_MAX_SHORT_LENGTH - 1];
+}
+
+const size_t lengthCount = CHECK_MAX_SHORT_LENGTH + 1 + sizeof(longLengths)/sizeof(longLengths[0]);
+const size_t maxLength = 4099;
+
+// Both are products of the same two floats, the SIMD ones may only differ by rounding
+bool matches(float value, float reference) {
+    return fabs(value - reference) <= fabs(reference)*4*1.2e-7f;
+}
+
+// Fixed point products are exact
+bool matches(qint32 value, qint32 reference) {
+    return value == reference;
+}
+
+// Runs kernel at every length and offset against the scalar reference. Returns the
+// number of mismatches, the first of them printed.
+template <typename Sample, typename Coefficient, typename Output, typename Kernel, typename Reference>
+int checkKernel(const char* name, Kernel kernel, Reference reference, const Sample* in, const Coefficient* window,
+        FILE* out) {
+    Output* expected = new Output[maxLength + CHECK_MAX_OFFSET + CHECK_GUARD];
+    Output* actual = new Output[maxLength + CHECK_MAX_OFFSET + CHECK_GUARD];
+    int mismatches = 0;
+    for (size_t l = 0; l < lengthCount; l++) {
+        size_t n = checkLength(l);
+        for (size_t inOffset = 0; inOffset <= CHECK_MAX_OFFSET; inOffset++) {
+            for (size_t outOffset = 0; outOffset <= CHECK_MAX_OFFSET; outOffset++) {
+                // The window is read at the samples' offset in the analysers, and at a
+                // different one here, to catch kernels relying on either
+                size_t windowOffset = CHECK_MAX_OFFSET - inOffset;
+                reference(&in[inOffset], &window[windowOffset], expected, n);
+                for (size_t i = 0; i < n + outOffset + CHECK_GUARD; i++)
+                    actual[i] = Output(-12345);
+                kernel(&in[inOffset], &window[windowOffset], &actual[outOffset], n);
+                for (size_t i = 0; i < n + outOffset + CHECK_GUARD; i++) {
+                    bool inside = i >= outOffset && i < outOffset + n;
+                    bool ok = inside ? matches(actual[i], expected[i - outOffset]) :
+                            actual[i] == Output(-12345);
+                    if (!ok && mismatches++ == 0) {
+                        fprintf(out, "%s: %s at %d of %d samples (offsets %d, %d)\n", name,
+                                inside ? "wrong value" : "wrote outside", int(i) - int(outOffset), int(n),
+                                int(inOffset), int(outOffset));
+                    }
+                }
+            }
+        }
+    }
+    delete[] expected;
+    delete[] actual;
+    return mismatches;
+}
+
+// The rounded fixed point products the Q15 and Q31 kernels promise
+void referenceQ15(const short* in, const qint16* window, qint16* out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = qint16(floor(double(in[i])*window[i]/32768 + 0.5));
+}
+
+void referenceQ31(const short* in, const qint32* window, qint32* out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = qint32(floor(double(in[i])*window[i]/32768 + 0.5));
+}
+
+} // namespace
+
+int checkKernels(FILE* out) {
+    size_t size = maxLength + 2*CHECK_MAX_OFFSET;
+    short* samples = new short[size];
+    // Full scale and both extremes, where conversions and saturation go wrong
+    srand(1);
+    for (size_t i = 0; i < size; i++)
+        samples[i] = short(rand() % 65536 - 32768);
+    samples[1] = -32768;
+    samples[2] = 32767;
+    const float* window = WindowCache::shared()->table(HannWindow, size);
+    const qint16* q15Window = WindowCache::shared()->q15Table(HannWindow, size);
+    const qint32* q31Window = WindowCache::shared()->q31Table(HannWindow, size);
+
+    int failed = 0;
+    WindowKernel kernels[CHECK_MAX_KERNELS];
+    const char* names[CHECK_MAX_KERNELS];
+    size_t count = windowKernels(kernels, names, CHECK_MAX_KERNELS);
+    for (size_t k = 0; k < count; k++) {
+        QByteArray name = QByteArray("window-") + names[k];
+        int mismatches = checkKernel<short, float, float>(name.constData(), kernels[k], windowSamplesScalar,
+                samples, window, out);
+        fprintf(out, "%-40s %s\n", name.constData(), mismatches == 0 ? "ok" : "FAILED");
+        failed += mismatches != 0;
+    }
+    int mismatches = checkKernel<short, qint16, qint16>("window-q15", windowSamplesQ15, referenceQ15,
+            samples, q15Window, out);
+    fprintf(out, "%-40s %s\n", "window-q15", mismatches == 0 ? "ok" : "FAILED");
+    failed += mismatches != 0;
+    mismatches = checkKernel<short, qint32, qint32>("window-q31", windowSamplesQ31, referenceQ31,
+            samples, q31Window, out);
+    fprintf(out, "%-40s %s\n", "window-q31", mismatches == 0 ? "ok" : "FAILED");
+    failed += mismatches != 0;
+
+    delete[] samples;
+    return failed;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "benchmark.hpp"
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Times the stages of the pitch pipeline and whole readings per detector, after\n"
+            "checking the SIMD kernels against their scalar reference.\n"
+            "  -k         kernel checks only\n"
+            "  -s         stages only\n"
+            "  -p         pipeline only\n"
+            "  -t SEC     shortest time per benchmark (default %.1f)\n"
+            "  -w FILE    write the results as a baseline\n"
+            "  -c FILE    compare against a baseline, exit with 1 on regressions\n",
+            program, BENCH_MIN_SECONDS);
+}
+
+int main(int argc, char** argv) {
+    bool stages = true;
+    bool pipeline = true;
+    bool checksOnly = false;
+    const char* writePath = NULL;
+    const char* comparePath = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "kspt:w:c:")) != -1) {
+        switch (opt) {
+        case 'k':
+            checksOnly = true;
+            break;
+        case 's':
+            pipeline = false;
+            break;
+        case 'p':
+            stages = false;
+            break;
+        case 't':
+            benchMinSeconds = atof(optarg);
+            break;
+        case 'w':
+            writePath = optarg;
+            break;
+        case 'c':
+            comparePath = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Timings of wrong kernels are worthless
+    if (checkKernels(stdout) != 0)
+        return EXIT_FAILURE;
+    if (checksOnly)
+        return EXIT_SUCCESS;
+
+    BenchReport report;
+    if (stages) {
+        for (size_t fftSize = 4096; fftSize <= 131072; fftSize *= 2)
+            benchStages(&report, fftSize);
+        benchEstimators(&report, 4096);
+    }
+    if (pipeline) {
+        for (int detector = 0; detector < PitchDetectorTypeCount; detector++)
+            benchPipeline(&report, PitchDetectorType(detector));
+        // The FFT peak detector once more in fixed point, against its float figures
+        for (int scalar = Q15FftScalar; scalar < FftScalarTypeCount; scalar++)
+            benchPipeline(&report, FftPeakPitchDetector, FftScalarType(scalar));
+        // And with the other peak estimators
+        for (int estimator = 0; estimator < PeakEstimatorCount; estimator++) {
+            if (estimator != PEAK_DEFAULT_ESTIMATOR)
+                benchPipeline(&report, FftPeakPitchDetector, FloatFftScalar, PeakEstimator(estimator));
+        }
+    }
+    report.print(stdout);
+
+    if (writePath != NULL && !report.writeBaseline(writePath)) {
+        fprintf(stderr, "Cannot write baseline %s\n", writePath);
+        return EXIT_FAILURE;
+    }
+    if (comparePath != NULL) {
+        int regressions = report.compare(comparePath, stdout);
+        if (regressions != 0)
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
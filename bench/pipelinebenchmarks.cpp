@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.hpp"
+
+#include <math.h>
+#include <string.h>
+#include "pitchanalyser.hpp"
+#include "signals.hpp"
+
+#define PIPELINE_SAMPLE_RATE 44100
+#define PIPELINE_FFT_SIZE 131072
+// Samples generated per signal. The first PIPELINE_FILL_SIZE of them fill the ring, the
+// rest is fed a hop at a time.
+#define PIPELINE_SIGNAL_SIZE 524288
+#define PIPELINE_FILL_SIZE 262144
+// New samples before each reading, as at the default update rate of 30 Hz
+#define PIPELINE_HOP_SIZE 1470
+// Readings taken per signal before the measured ones, to fill the analyser's history
+// and let the strobe filters settle
+#define PIPELINE_SETTLE_READINGS 8
+#define PIPELINE_NOISE_TRIALS 8
+
+namespace {
+
+// Guitar strings, a few more notes across the range and a high one
+const int toneNotes[] = { 40, 45, 50, 55, 59, 64, 69, 76, 84 };
+const int chordNotes[] = { 60, 64, 67 };
+
+// One reading after a hop of new samples, like the analysis thread does it. Wraps
+// around to the start of the signal once it runs out, which only matters for timing.
+struct ReadingRun {
+    PitchAnalyser* analyser;
+    RingBuffer<short>* ring;
+    const short* signal;
+    size_t position;
+    NoteInfo note;
+
+    void operator()() {
+        if (position + PIPELINE_HOP_SIZE > PIPELINE_SIGNAL_SIZE)
+            position = 0;
+        ring->write(&signal[position], PIPELINE_HOP_SIZE);
+        position += PIPELINE_HOP_SIZE;
+        note = analyser->getNote(ring);
+    }
+
+    // Fills the ring with the start of a fresh signal and settles the analyser on it
+    void load() {
+        ring->write(signal, PIPELINE_FILL_SIZE);
+        position = PIPELINE_FILL_SIZE;
+        analyser->reset();
+        for (int i = 0; i < PIPELINE_SETTLE_READINGS; i++)
+            (*this)();
+    }
+};
+
+// Cents from the reading's fundamental to the nearest of the given notes, or a
+// negative value if there was no reading
+double readingError(const NoteInfo& note, const int* notes, int count) {
+    if (note.note[0] == 0 || note.harmonic < 1)
+        return -1;
+    double fundamental = note.frequency/note.harmonic;
+    double best = 1e9;
+    for (int i = 0; i < count; i++)
+        best = qMin(best, fabs(centsBetween(fundamental, midiToFreq(notes[i]))));
+    return best;
+}
+
+}
+
+void benchPipeline(BenchReport* report, PitchDetectorType detector, FftScalarType scalar, PeakEstimator estimator) {
+    PitchAnalyser analyser(PIPELINE_SAMPLE_RATE, 440, PIPELINE_FFT_SIZE, scalar);
+    analyser.setDetector(detector);
+    analyser.setPeakEstimator(estimator);
+    RingBuffer<short> ring(PIPELINE_FILL_SIZE);
+    short* signal = new short[PIPELINE_SIGNAL_SIZE];
+    ReadingRun run = { &analyser, &ring, signal, 0, NoteInfo() };
+
+    QByteArray prefix = QByteArray("pipeline.") + pitchDetectorName(detector);
+    if (scalar != FloatFftScalar)
+        prefix += QByteArray("-") + fftScalarName(scalar);
+    if (detector == FftPeakPitchDetector && estimator != PEAK_DEFAULT_ESTIMATOR)
+        prefix += QByteArray("-") + peakEstimatorName(estimator);
+    prefix += ".";
+    int toneCount = int(sizeof(toneNotes)/sizeof(toneNotes[0]));
+    double totalTime = 0;
+    double totalFrame = 0;
+    double totalError = 0;
+    double maxError = 0;
+    int misses = 0;
+
+    // Single tones, slightly detuned so that they do not sit on a bin
+    for (int t = 0; t < toneCount; t++) {
+        double freq = midiToFreq(toneNotes[t])*pow(2.0, 7/1200.0);
+        memset(signal, 0, sizeof(short)*PIPELINE_SIGNAL_SIZE);
+        addTone(signal, PIPELINE_SIGNAL_SIZE, PIPELINE_SAMPLE_RATE, freq, 8000, 0.3);
+        addNoise(signal, PIPELINE_SIGNAL_SIZE, 50, t + 1);
+        analyser.setTargetNote(toneNotes[t]);
+        run.load();
+
+        // Accuracy from a reading on the clean signal, before timing wraps around
+        run();
+        NoteInfo reading = run.note;
+        totalFrame += analyser.frameSize();
+        totalTime += timeRuns(run);
+        run.note = reading;
+        double error = readingError(run.note, &toneNotes[t], 1);
+        if (error < 0) {
+            misses++;
+            continue;
+        }
+        // Against the detuned frequency, not the note
+        error = fabs(centsBetween(run.note.frequency/run.note.harmonic, freq));
+        totalError += error;
+        maxError = qMax(maxError, error);
+    }
+
+    double readingTime = totalTime/toneCount;
+    report->add(prefix + "reading", readingTime*1000, "ms", TimeMetric);
+    report->add(prefix + "readings-per-second", 1/readingTime, "1/s", RateMetric);
+    report->add(prefix + "ns-per-sample", readingTime*1000000000/analyser.frameSize(), "ns/sample", TimeMetric);
+    // The FFT size the detector settled on for the tones, smaller means less latency
+    report->add(prefix + "frame-size", totalFrame/toneCount, "samples", TimeMetric);
+    report->add(prefix + "tone-mean-error", toneCount > misses ? totalError/(toneCount - misses) : 0, "cents", AccuracyMetric);
+    report->add(prefix + "tone-max-error", maxError, "cents", AccuracyMetric);
+    report->add(prefix + "tone-misses", misses, "readings", AccuracyMetric);
+
+    // A major triad, any of its notes is a right answer
+    memset(signal, 0, sizeof(short)*PIPELINE_SIGNAL_SIZE);
+    for (int c = 0; c < 3; c++)
+        addTone(signal, PIPELINE_SIGNAL_SIZE, PIPELINE_SAMPLE_RATE, midiToFreq(chordNotes[c]), 5000, c);
+    analyser.setTargetNote(chordNotes[0]);
+    run.load();
+    run();
+    double chordError = readingError(run.note, chordNotes, 3);
+    report->add(prefix + "chord-error", chordError < 0 ? 1200 : chordError, "cents", AccuracyMetric);
+
+    // Noise alone should not produce readings
+    int falseReadings = 0;
+    for (int i = 0; i < PIPELINE_NOISE_TRIALS; i++) {
+        memset(signal, 0, sizeof(short)*PIPELINE_SIGNAL_SIZE);
+        addNoise(signal, PIPELINE_SIGNAL_SIZE, 2000, 1000 + i);
+        run.load();
+        run();
+        if (run.note.note[0] != 0)
+            falseReadings++;
+    }
+    report->add(prefix + "noise-false-readings", double(falseReadings)/PIPELINE_NOISE_TRIALS, "ratio", AccuracyMetric);
+
+    delete[] signal;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "signals.hpp"
+
+#include <math.h>
+
+static short clip(double v) {
+    if (v > 32767)
+        return 32767;
+    if (v < -32768)
+        return -32768;
+    return short(v);
+}
+
+double midiToFreq(int note) {
+    return 440*pow(2.0, (note - 69)/12.0);
+}
+
+double centsBetween(double f, double reference) {
+    return 1200*log(f/reference)/log(2.0);
+}
+
+void addTone(short* out, size_t n, int sampleRate, double freq, float amplitude, double phase) {
+    for (int h = 1; h <= SIGNAL_HARMONICS; h++) {
+        double partialFreq = freq*h;
+        if (partialFreq >= sampleRate/2)
+            break;
+        double step = 2*M_PI*partialFreq/sampleRate;
+        double a = amplitude/h;
+        for (size_t i = 0; i < n; i++)
+            out[i] = clip(out[i] + a*sin(step*i + phase*h));
+    }
+}
+
+void addNoise(short* out, size_t n, float amplitude, unsigned int seed) {
+    for (size_t i = 0; i < n; i++) {
+        seed = seed*1103515245 + 12345;
+        double r = double((seed >> 8) & 0xffff)/0xffff*2 - 1;
+        out[i] = clip(out[i] + amplitude*r);
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef Signals_HPP_
+#define Signals_HPP_
+
+#include <stddef.h>
+
+// Partials of the synthetic tones, relative to the fundamental
+#define SIGNAL_HARMONICS 6
+
+// Frequency of a MIDI note at A4 = 440 Hz
+double midiToFreq(int note);
+// Distance of f from reference in cents
+double centsBetween(double f, double reference);
+
+// Adds a tone with SIGNAL_HARMONICS partials falling off like a plucked string
+void addTone(short* out, size_t n, int sampleRate, double freq, float amplitude, double phase = 0);
+// Adds uniform white noise with the given peak amplitude
+void addNoise(short* out, size_t n, float amplitude, unsigned int seed);
+
+#endif /* Signals_HPP_ */
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.hpp"
+
+#include <string.h>
+#include "fftplancache.hpp"
+#include "fftscalar.hpp"
+#include "harmonicanalyser.hpp"
+#include "pitchanalyser.hpp"
+#include "signals.hpp"
+#include "spectralpeaks.hpp"
+#include "windowing.hpp"
+
+#define STAGE_SAMPLE_RATE 44100
+// Calls per run for stages that only take a few nanoseconds
+#define STAGE_INNER_CALLS 1000
+
+namespace {
+
+// State shared by the stages, each stage reads what the previous one produced
+struct StageData {
+    size_t n;
+    short* samples;
+    const float* window;
+    kiss_fft_scalar* timeData;
+    FftWorkspace workspace;
+    const FftPlan* plan;
+    SpectralPeakPicker* picker;
+    SpectralPeak peak;
+    HarmonicAnalyser* harmonics;
+    PitchAnalyser* analyser;
+    float sink;
+};
+
+struct ConvertStage {
+    StageData* d;
+    void operator()() {
+        for (size_t i = 0; i < d->n; i++)
+            d->timeData[i] = float(d->samples[i]);
+    }
+};
+
+struct WindowScalarStage {
+    StageData* d;
+    void operator()() { windowSamplesScalar(d->samples, d->window, d->timeData, d->n); }
+};
+
+struct WindowStage {
+    StageData* d;
+    WindowKernel kernel;
+    void operator()() { kernel(d->samples, d->window, d->timeData, d->n); }
+};
+
+struct FftStage {
+    StageData* d;
+    void operator()() { d->plan->forward(d->timeData, d->workspace.freqData(), d->workspace.scratch()); }
+};
+
+struct PeakStage {
+    StageData* d;
+    void operator()() { d->picker->find(d->workspace.freqData(), 1, d->n/2, &d->peak, 1); }
+};
+
+struct InterpolationStage {
+    StageData* d;
+    void operator()() {
+        float sum = 0;
+        for (int i = 0; i < STAGE_INNER_CALLS; i++)
+            sum += logParabolicOffset(d->peak.powerL, d->peak.power + i, d->peak.powerR);
+        d->sink = sum;
+    }
+};
+
+struct NoteStage {
+    StageData* d;
+    void operator()() {
+        NoteInfo note;
+        for (int i = 0; i < STAGE_INNER_CALLS; i++)
+            d->analyser->convertFreqToNote(440.0f + i*0.01f, 1000, 1, &note);
+        d->sink = note.centsDiff;
+    }
+};
+
+struct OvertoneStage {
+    StageData* d;
+    float freq;
+    void operator()() { d->sink = float(d->harmonics->harmonicOf(d->picker->power(), freq)); }
+};
+
+// The stages that depend on the FFT's scalar type, in the same order as above
+template <typename T>
+struct ScalarStages {
+    typedef FftScalar<T> Scalar;
+
+    StageData* d;
+    const T* window;
+    BasicFftWorkspace<T> workspace;
+    const typename Scalar::Plan* plan;
+    typename Scalar::WindowKernel kernel;
+
+    struct Window {
+        ScalarStages* s;
+        void operator()() { s->kernel(s->d->samples, s->window, s->workspace.timeData(), s->d->n); }
+    };
+
+    struct Fft {
+        ScalarStages* s;
+        void operator()() { s->plan->forward(s->workspace.timeData(), s->workspace.freqData(), s->workspace.scratch()); }
+    };
+
+    struct Peaks {
+        ScalarStages* s;
+        void operator()() {
+            s->d->picker->find(s->workspace.freqData(), 1, s->d->n/2, &s->d->peak, 1, 0, Scalar::powerGain(s->d->n));
+        }
+    };
+
+    void run(BenchReport* report, const QByteArray& prefix, double perSample) {
+        window = Scalar::window(HannWindow, d->n);
+        workspace.reserve(d->n);
+        plan = Scalar::plan(d->n);
+        kernel = Scalar::windowKernel();
+
+        QByteArray name = prefix + fftScalarName(Scalar::type()) + ".";
+        Window windowStage = { this };
+        report->add(name + "window", timeRuns(windowStage)*perSample, "ns/sample", TimeMetric);
+        Fft fft = { this };
+        report->add(name + "fft", timeRuns(fft)*perSample, "ns/sample", TimeMetric);
+        Peaks peaks = { this };
+        report->add(name + "peaks", timeRuns(peaks)*perSample, "ns/sample", TimeMetric);
+    }
+};
+
+}
+
+void benchStages(BenchReport* report, size_t fftSize) {
+    StageData d;
+    d.n = fftSize;
+    d.samples = new short[fftSize];
+    memset(d.samples, 0, sizeof(short)*fftSize);
+    addTone(d.samples, fftSize, STAGE_SAMPLE_RATE, 220, 6000);
+    addNoise(d.samples, fftSize, 100, 1);
+    d.window = WindowCache::shared()->table(HannWindow, fftSize);
+    d.workspace.reserve(fftSize);
+    d.timeData = d.workspace.timeData();
+    d.plan = FftPlanCache::shared()->plan(fftSize);
+    d.picker = new SpectralPeakPicker(fftSize/2 + 1);
+    d.harmonics = new HarmonicAnalyser(STAGE_SAMPLE_RATE, fftSize);
+    d.analyser = new PitchAnalyser(STAGE_SAMPLE_RATE, 440, fftSize);
+    d.sink = 0;
+
+    QByteArray prefix = "stage." + QByteArray::number(int(fftSize)) + ".";
+    double perSample = 1000000000.0/fftSize;
+    double perCall = 1000000000.0/STAGE_INNER_CALLS;
+
+    ConvertStage convert = { &d };
+    report->add(prefix + "convert", timeRuns(convert)*perSample, "ns/sample", TimeMetric);
+
+    WindowScalarStage windowScalar = { &d };
+    report->add(prefix + "window-scalar", timeRuns(windowScalar)*perSample, "ns/sample", TimeMetric);
+
+    const char* kernelName;
+    WindowStage window = { &d, windowKernel(&kernelName) };
+    report->add(prefix + "window-" + kernelName, timeRuns(window)*perSample, "ns/sample", TimeMetric);
+
+    FftStage fft = { &d };
+    report->add(prefix + "fft", timeRuns(fft)*perSample, "ns/sample", TimeMetric);
+
+    PeakStage peaks = { &d };
+    report->add(prefix + "peaks", timeRuns(peaks)*perSample, "ns/sample", TimeMetric);
+
+    InterpolationStage interpolation = { &d };
+    report->add(prefix + "interpolation", timeRuns(interpolation)*perCall, "ns/call", TimeMetric);
+
+    NoteStage note = { &d };
+    report->add(prefix + "note", timeRuns(note)*perCall, "ns/call", TimeMetric);
+
+    OvertoneStage overtone = { &d, float(d.peak.bin)*STAGE_SAMPLE_RATE/fftSize };
+    report->add(prefix + "overtone", timeRuns(overtone)*perSample, "ns/sample", TimeMetric);
+
+    // The float stages above are the FFT peak detector's default, these are its fixed
+    // point alternatives
+    ScalarStages<qint16> q15Stages;
+    q15Stages.d = &d;
+    q15Stages.run(report, prefix, perSample);
+    ScalarStages<qint32> q31Stages;
+    q31Stages.d = &d;
+    q31Stages.run(report, prefix, perSample);
+
+    delete d.analyser;
+    delete d.harmonics;
+    delete d.picker;
+    delete[] d.samples;
+}
@@ -0,0 +1,49 @@
+# Benchmarks for the pitch pipeline. Builds against Qt 4 on the desktop:
+#   qmake bench/tuner-bench.pro && make && ./tuner-bench -w baseline.txt
+# KISSFFT points at the kissfft sources, by default next to this project like the
+# app expects them.
+
+TEMPLATE = app
+TARGET = tuner-bench
+CONFIG += console warn_on release
+CONFIG -= app_bundle
+QT = core
+
+BASEDIR = $$quote($$_PRO_FILE_PWD_/..)
+isEmpty(KISSFFT): KISSFFT = $$quote($$BASEDIR/../kissfft)
+
+INCLUDEPATH += $$quote($$BASEDIR/src) \
+    $$quote($$BASEDIR/bench) \
+    $$quote($$KISSFFT/public) \
+    $$quote($$KISSFFT/src)
+
+SOURCES += \
+    $$quote($$BASEDIR/bench/benchmark.cpp) \
+    $$quote($$BASEDIR/bench/estimatorbenchmarks.cpp) \
+    $$quote($$BASEDIR/bench/kernelchecks.cpp) \
+    $$quote($$BASEDIR/bench/main.cpp) \
+    $$quote($$BASEDIR/bench/pipelinebenchmarks.cpp) \
+    $$quote($$BASEDIR/bench/signals.cpp) \
+    $$quote($$BASEDIR/bench/stagebenchmarks.cpp) \
+    $$quote($$BASEDIR/src/fftpeakdetector.cpp) \
+    $$quote($$BASEDIR/src/fftplancache.cpp) \
+    $$quote($$BASEDIR/src/fftscalar.cpp) \
+    $$quote($$BASEDIR/src/fftspectrum.cpp) \
+    $$quote($$BASEDIR/src/fixedfft.cpp) \
+    $$quote($$BASEDIR/src/harmonicanalyser.cpp) \
+    $$quote($$BASEDIR/src/peakestimator.cpp) \
+    $$quote($$BASEDIR/src/phasevocoderdetector.cpp) \
+    $$quote($$BASEDIR/src/pitchanalyser.cpp) \
+    $$quote($$BASEDIR/src/pitchdetector.cpp) \
+    $$quote($$BASEDIR/src/pitchstabiliser.cpp) \
+    $$quote($$BASEDIR/src/resolutioncontroller.cpp) \
+    $$quote($$BASEDIR/src/spectralpeaks.cpp) \
+    $$quote($$BASEDIR/src/strobedetector.cpp) \
+    $$quote($$BASEDIR/src/windowing.cpp) \
+    $$quote($$BASEDIR/src/yindetector.cpp) \
+    $$quote($$BASEDIR/src/zoomfftdetector.cpp) \
+    $$quote($$KISSFFT/src/kiss_fft.c)
+
+HEADERS += \
+    $$quote($$BASEDIR/bench/benchmark.hpp) \
+    $$quote($$BASEDIR/bench/signals.hpp)
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "batchworker.hpp"
+
+#include <limits>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Steps to the next record of the given type, readings of the first channel only
+static bool nextRecord(const CaptureTraceReader& trace, size_t* cursor, CaptureTraceRecordType type,
+        CaptureTraceEntry* entry) {
+    while (trace.next(cursor, entry)) {
+        if (entry->type == type && (type != ReadingTraceRecord || entry->reading->channel == 0))
+            return true;
+    }
+    return false;
+}
+
+BatchWorker::BatchWorker(const BatchSettings* settings, BatchQueue* queue, QObject* parent)
+    : QThread(parent), settings(settings), queue(queue) {
+    analyser = NULL;
+    analyserRate = 0;
+    samples = NULL;
+    chunk = NULL;
+    chunkSize = 0;
+    analysedSeconds = 0;
+    analysedFiles = 0;
+}
+
+BatchWorker::~BatchWorker() {
+    wait();
+    delete analyser;
+    delete samples;
+    delete[] chunk;
+}
+
+void BatchWorker::run() {
+    forever {
+        int index = queue->next.fetchAndAddRelaxed(1);
+        if (index >= queue->count)
+            break;
+        if (!analyseFile(queue->paths[index])) {
+            fprintf(stderr, "%s: analysis failed\n", queue->paths[index]);
+            queue->failed.ref();
+        }
+    }
+}
+
+void BatchWorker::prepare(int sampleRate, size_t hop) {
+    if (analyser == NULL || analyserRate != sampleRate) {
+        delete analyser;
+        analyser = new PitchAnalyser(sampleRate, settings->tuningFreq, settings->fftSize, settings->fftScalar);
+        analyser->setDetector(settings->detector);
+        analyser->setPeakEstimator(settings->peakEstimator);
+        analyser->setLockReadings(settings->lockReadings);
+        analyser->setTargetNote(settings->targetNote);
+        analyserRate = sampleRate;
+    }
+    analyser->reset();
+
+    // The ring has to hold a whole frame plus the hop that is being written
+    size_t needed = analyser->frameSize() + hop;
+    if (samples == NULL || samples->capacity() < needed) {
+        delete samples;
+        samples = new RingBuffer<short>(needed);
+    }
+    if (chunkSize < hop) {
+        delete[] chunk;
+        chunk = new short[hop];
+        chunkSize = hop;
+    }
+}
+
+bool BatchWorker::analyseFile(const char* path) {
+    CaptureTraceReader trace;
+    if (trace.open(path))
+        return analyseTrace(path, trace);
+
+    MappedAudioFile file;
+    if (!file.open(path, settings->rawSampleRate, settings->rawChannels))
+        return false;
+
+    size_t hop = size_t(file.sampleRate()*settings->hopMs/1000);
+    if (hop < 1)
+        hop = 1;
+    prepare(file.sampleRate(), hop);
+
+    char outPath[1024];
+    trackPath(path, outPath, sizeof(outPath));
+    if (!writer.open(outPath, settings->format, file.sampleRate(), hop, settings->tuningFreq))
+        return false;
+
+    // Readings start once the ring holds a whole frame of this file, so nothing of the
+    // previous file is looked at
+    size_t frame = analyser->frameSize();
+    for (size_t pos = 0; pos < file.frames(); pos += hop) {
+        size_t n = file.frames() - pos < hop ? file.frames() - pos : hop;
+        if (file.channelCount() == 1) {
+            samples->write(&file.data()[pos], n);
+        } else {
+            file.mixDown(pos, n, chunk);
+            samples->write(chunk, n);
+        }
+
+        if (pos + n >= frame) {
+            NoteInfo note = analyser->getNote(samples);
+            writer.write(double(pos + n)/file.sampleRate(), note);
+        }
+    }
+
+    analysedSeconds += file.duration();
+    analysedFiles++;
+    return writer.close();
+}
+
+bool BatchWorker::analyseTrace(const char* path, const CaptureTraceReader& trace) {
+    size_t hop = size_t(trace.sampleRate()*settings->hopMs/1000);
+    if (hop < 1)
+        hop = 1;
+    // Fragments go into the ring whole
+    prepare(trace.sampleRate(), hop > trace.fragmentSize() ? hop : trace.fragmentSize());
+
+    char outPath[1024];
+    trackPath(path, outPath, sizeof(outPath));
+    if (!writer.open(outPath, settings->format, trace.sampleRate(), hop, settings->tuningFreq))
+        return false;
+
+    size_t readings = trace.begin();
+    CaptureTraceEntry reading;
+    bool haveReading = nextRecord(trace, &readings, ReadingTraceRecord, &reading);
+    bool followReadings = haveReading;
+    int recordedNotes = 0;
+    int differing = 0;
+
+    size_t frame = analyser->frameSize();
+    size_t pos = 0;
+    size_t analysed = 0;
+    size_t fragments = trace.begin();
+    CaptureTraceEntry fragment;
+    while (nextRecord(trace, &fragments, FragmentTraceRecord, &fragment)) {
+        samples->write(fragment.samples, fragment.frames);
+        pos += fragment.frames;
+
+        if (!followReadings) {
+            if (pos >= frame && pos - analysed >= hop) {
+                writer.write(double(pos)/trace.sampleRate(), analyser->getNote(samples));
+                analysed = pos;
+            }
+            continue;
+        }
+
+        // A reading was made from this fragment if it was captured before the next one
+        size_t peek = fragments;
+        CaptureTraceEntry following;
+        qint64 nextArrival = nextRecord(trace, &peek, FragmentTraceRecord, &following) ?
+                following.time : std::numeric_limits<qint64>::max();
+        for (; haveReading && reading.reading->captured < nextArrival;
+                haveReading = nextRecord(trace, &readings, ReadingTraceRecord, &reading)) {
+            if (pos < frame)
+                continue;
+            NoteInfo note = analyser->getNote(samples);
+            writer.write(double(pos)/trace.sampleRate(), note);
+
+            const CaptureTraceReading* recorded = reading.reading;
+            if (recorded->note[0] != 0) {
+                recordedNotes++;
+                if (strncmp(note.note, recorded->note, sizeof(recorded->note)) != 0 ||
+                        fabs(note.centsDiff - recorded->centsDiff) > TRACE_MATCH_CENTS)
+                    differing++;
+            }
+        }
+    }
+    if (followReadings)
+        fprintf(stderr, "%s: %d of %d recorded notes replayed differently\n", path, differing, recordedNotes);
+
+    analysedSeconds += trace.duration();
+    analysedFiles++;
+    return writer.close();
+}
+
+void BatchWorker::trackPath(const char* path, char* out, size_t size) const {
+    const char* suffix = settings->format == BinaryPitchTrack ? ".ptrk" : ".csv";
+    if (settings->outputDir == NULL) {
+        snprintf(out, size, "%s%s", path, suffix);
+        return;
+    }
+    const char* name = strrchr(path, '/');
+    name = name != NULL ? name + 1 : path;
+    snprintf(out, size, "%s/%s%s", settings->outputDir, name, suffix);
+}
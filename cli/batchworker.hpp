@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BatchWorker_HPP_
+#define BatchWorker_HPP_
+
+#include <QAtomicInt>
+#include <QThread>
+#include "capturetrace.hpp"
+#include "mappedaudiofile.hpp"
+#include "pitchanalyser.hpp"
+#include "pitchtrack.hpp"
+#include "ringbuffer.hpp"
+
+// Replayed readings of a capture trace further than this from the recorded ones count
+// as differing
+#define TRACE_MATCH_CENTS 1.0f
+
+// Settings shared by all workers of a batch
+struct BatchSettings {
+    PitchDetectorType detector;
+    size_t fftSize;
+    FftScalarType fftScalar;
+    PeakEstimator peakEstimator;
+    int lockReadings;
+    int tuningFreq;
+    // MIDI note the strobe detector listens for
+    int targetNote;
+    float hopMs;
+    // For files without a WAV header
+    int rawSampleRate;
+    int rawChannels;
+    PitchTrackFormat format;
+    // Output directory, NULL to write the tracks next to the input files
+    const char* outputDir;
+};
+
+// The list of files to analyse. Workers take the next file off it until none are left.
+struct BatchQueue {
+    char** paths;
+    int count;
+    QAtomicInt next;
+    QAtomicInt failed;
+};
+
+/*
+ * Streams files from a BatchQueue through its own PitchAnalyser, one hop at a time, and
+ * writes a pitch track for each. The analyser and with it the FFT workspaces are kept
+ * from file to file and only rebuilt when the sample rate changes, so a worker does
+ * not allocate per file in the common case.
+ *
+ * Capture traces are replayed fragment by fragment. Their first channel is analysed
+ * where the recording made its readings, or every hop if it has none, and notes that
+ * come out differently from the recorded ones are reported.
+ */
+class BatchWorker : public QThread {
+public:
+    BatchWorker(const BatchSettings* settings, BatchQueue* queue, QObject* parent = 0);
+    virtual ~BatchWorker();
+
+    // Seconds of audio this worker has analysed
+    double audioSeconds() const { return analysedSeconds; }
+    int fileCount() const { return analysedFiles; }
+
+protected:
+    virtual void run();
+
+private:
+    BatchWorker(const BatchWorker&);
+    BatchWorker& operator=(const BatchWorker&);
+
+    bool analyseFile(const char* path);
+    bool analyseTrace(const char* path, const CaptureTraceReader& trace);
+    void prepare(int sampleRate, size_t hop);
+    void trackPath(const char* path, char* out, size_t size) const;
+
+    const BatchSettings* settings;
+    BatchQueue* queue;
+
+    PitchAnalyser* analyser;
+    int analyserRate;
+    RingBuffer<short>* samples;
+    short* chunk;
+    size_t chunkSize;
+    PitchTrackWriter writer;
+
+    double analysedSeconds;
+    int analysedFiles;
+};
+
+#endif /* BatchWorker_HPP_ */
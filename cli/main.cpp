@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QtGlobal>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "batchworker.hpp"
+
+static bool verbose = false;
+
+// File and trace loaders explain their failures through qDebug, the batch only names the
+// files that failed unless asked for the details
+static void messageHandler(QtMsgType type, const char* message) {
+    if (type == QtDebugMsg && !verbose)
+        return;
+    fprintf(stderr, "%s\n", message);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options] file...\n"
+            "Analyses 16 bit WAV or raw files, or replays capture traces, and writes a pitch\n"
+            "track for each of them.\n"
+            "  -d DETECTOR  fft, yin, zoom, strobe or vocoder (default fft)\n"
+            "  -s SCALAR    arithmetic of the fft detector: float, q15 or q31 (default %s)\n"
+            "  -e METHOD    peak estimator of the fft detector: parabolic, gaussian, quinn\n"
+            "               or jain (default %s)\n"
+            "  -n NOTE      note the strobe detector tunes to, as a MIDI number or a name\n"
+            "               like E1 or A#3 with octaves counted from A (default A4); picks\n"
+            "               the strobe detector unless -d is given\n"
+            "  -l N         readings that have to agree before a note is given (default %d)\n"
+            "  -j N         number of worker threads (default: one per CPU)\n"
+            "  -h MS        hop between readings in milliseconds (default 33.3)\n"
+            "  -t HZ        tuning frequency of A4 (default 440)\n"
+            "  -r RATE      sample rate of files without a WAV header\n"
+            "  -c N         channels of files without a WAV header (default 1)\n"
+            "  -b           write binary tracks instead of CSV\n"
+            "  -o DIR       write tracks to DIR instead of next to the input files\n"
+            "  -v           show why files failed to load\n",
+            program, fftScalarName(FFT_DEFAULT_SCALAR), peakEstimatorName(PEAK_DEFAULT_ESTIMATOR),
+            STABILITY_LOCK_READINGS);
+}
+
+int main(int argc, char** argv) {
+    qInstallMsgHandler(messageHandler);
+
+    BatchSettings settings;
+    settings.detector = FftPeakPitchDetector;
+    settings.fftSize = 131072;
+    settings.fftScalar = FFT_DEFAULT_SCALAR;
+    settings.peakEstimator = PEAK_DEFAULT_ESTIMATOR;
+    settings.lockReadings = STABILITY_LOCK_READINGS;
+    settings.tuningFreq = 440;
+    settings.targetNote = 69;
+    settings.hopMs = 1000/30.0f;
+    settings.rawSampleRate = 0;
+    settings.rawChannels = 1;
+    settings.format = CsvPitchTrack;
+    settings.outputDir = NULL;
+    int workerCount = int(sysconf(_SC_NPROCESSORS_ONLN));
+
+    bool detectorGiven = false;
+    bool targetGiven = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:s:e:n:l:j:h:t:r:c:bo:v")) != -1) {
+        switch (opt) {
+        case 'd':
+            if (!parsePitchDetector(optarg, &settings.detector)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            detectorGiven = true;
+            break;
+        case 's':
+            if (!parseFftScalar(optarg, &settings.fftScalar)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'e':
+            if (!parsePeakEstimator(optarg, &settings.peakEstimator)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'n':
+            if (!parseNoteName(optarg, &settings.targetNote)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            targetGiven = true;
+            break;
+        case 'l':
+            settings.lockReadings = atoi(optarg);
+            break;
+        case 'j':
+            workerCount = atoi(optarg);
+            break;
+        case 'h':
+            settings.hopMs = float(atof(optarg));
+            break;
+        case 't':
+            settings.tuningFreq = atoi(optarg);
+            break;
+        case 'r':
+            settings.rawSampleRate = atoi(optarg);
+            break;
+        case 'c':
+            settings.rawChannels = atoi(optarg);
+            break;
+        case 'b':
+            settings.format = BinaryPitchTrack;
+            break;
+        case 'o':
+            settings.outputDir = optarg;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc || settings.hopMs <= 0 || settings.tuningFreq <= 0 || settings.lockReadings < 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (targetGiven && !detectorGiven)
+        settings.detector = StrobePitchDetector;
+
+    BatchQueue queue;
+    queue.paths = &argv[optind];
+    queue.count = argc - optind;
+    if (workerCount < 1)
+        workerCount = 1;
+    if (workerCount > queue.count)
+        workerCount = queue.count;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    BatchWorker** workers = new BatchWorker*[workerCount];
+    for (int i = 0; i < workerCount; i++) {
+        workers[i] = new BatchWorker(&settings, &queue);
+        workers[i]->start();
+    }
+
+    double audioSeconds = 0;
+    int files = 0;
+    for (int i = 0; i < workerCount; i++) {
+        workers[i]->wait();
+        audioSeconds += workers[i]->audioSeconds();
+        files += workers[i]->fileCount();
+        delete workers[i];
+    }
+    delete[] workers;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double wallSeconds = double(t1.tv_sec - t0.tv_sec) + double(t1.tv_nsec - t0.tv_nsec)/1000000000;
+    int failed = queue.failed.fetchAndAddRelaxed(0);
+
+    fprintf(stderr, "%d files, %.1f s of audio in %.2f s (%d workers): %.1f audio-s/s\n",
+            files, audioSeconds, wallSeconds, workerCount, wallSeconds > 0 ? audioSeconds/wallSeconds : 0);
+    if (failed > 0)
+        fprintf(stderr, "%d files failed\n", failed);
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pitchtrack.hpp"
+
+#include <math.h>
+#include <string.h>
+
+// Output is written in large blocks, the workers produce it much faster than a disk
+// takes small writes
+#define PITCH_TRACK_BUFFER_SIZE (256*1024)
+
+PitchTrackWriter::PitchTrackWriter() : file(NULL), format(CsvPitchTrack), tuningFreq(440) {
+    buffer = new char[PITCH_TRACK_BUFFER_SIZE];
+}
+
+PitchTrackWriter::~PitchTrackWriter() {
+    close();
+    delete[] buffer;
+}
+
+bool PitchTrackWriter::open(const char* path, PitchTrackFormat format, int sampleRate, size_t hopSize, float tuningFreq) {
+    close();
+    if ((file = fopen(path, format == BinaryPitchTrack ? "wb" : "w")) == NULL)
+        return false;
+    setvbuf(file, buffer, _IOFBF, PITCH_TRACK_BUFFER_SIZE);
+    this->format = format;
+    this->tuningFreq = tuningFreq;
+
+    if (format == BinaryPitchTrack) {
+        PitchTrackHeader header;
+        memcpy(header.magic, PITCH_TRACK_MAGIC, 4);
+        header.version = PITCH_TRACK_VERSION;
+        header.sampleRate = quint32(sampleRate);
+        header.hopSize = quint32(hopSize);
+        header.tuningFreq = tuningFreq;
+        fwrite(&header, sizeof(header), 1, file);
+    } else {
+        fprintf(file, "time,frequency,note,cents,amplitude,harmonic,confidence\n");
+    }
+    return true;
+}
+
+void PitchTrackWriter::write(double time, const NoteInfo& note) {
+    bool havePitch = note.note[0] != 0;
+    if (format == BinaryPitchTrack) {
+        PitchTrackRecord record;
+        record.time = float(time);
+        record.frequency = havePitch ? note.frequency : 0;
+        record.centsDiff = havePitch ? note.centsDiff : 0;
+        record.amplitude = havePitch ? note.amplitude : 0;
+        record.midiNote = -1;
+        record.harmonic = qint16(note.harmonic);
+        record.confidence = note.confidence;
+        // The note named, which may be off the fundamental by more than half a semitone
+        if (havePitch && note.harmonic > 0)
+            record.midiNote = qint16(floor(69 + 12*log2(note.frequency/note.harmonic/tuningFreq) - note.centsDiff/100 + 0.5));
+        fwrite(&record, sizeof(record), 1, file);
+    } else if (havePitch) {
+        fprintf(file, "%.4f,%.3f,%s,%.2f,%.1f,%d,%.2f\n", time, note.frequency, note.note, note.centsDiff,
+                note.amplitude, note.harmonic, note.confidence);
+    } else {
+        fprintf(file, "%.4f,,,,,,%.2f\n", time, note.confidence);
+    }
+}
+
+bool PitchTrackWriter::close() {
+    if (file == NULL)
+        return true;
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+    return ok;
+}
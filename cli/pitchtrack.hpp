@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PitchTrack_HPP_
+#define PitchTrack_HPP_
+
+#include <QtGlobal>
+#include <stdio.h>
+#include "noteinfo.hpp"
+
+#define PITCH_TRACK_MAGIC "PTRK"
+#define PITCH_TRACK_VERSION 2
+
+enum PitchTrackFormat {
+    CsvPitchTrack,
+    BinaryPitchTrack
+};
+
+// Binary tracks start with this header, followed by one record per analysed frame.
+// Fields are in host byte order, which is little endian on every supported target.
+struct PitchTrackHeader {
+    char magic[4];
+    quint32 version;
+    quint32 sampleRate;
+    quint32 hopSize;
+    float tuningFreq;
+};
+
+struct PitchTrackRecord {
+    // End of the analysed frame in seconds from the start of the file
+    float time;
+    // 0 if the frame held no stable pitch
+    float frequency;
+    float centsDiff;
+    float amplitude;
+    // MIDI note number of the fundamental, -1 without a pitch
+    qint16 midiNote;
+    qint16 harmonic;
+    // See NoteInfo::confidence, also given for frames without a stable pitch. Since
+    // version 2.
+    float confidence;
+};
+
+/*
+ * Writes the readings for one file as CSV or as packed binary records.
+ */
+class PitchTrackWriter {
+public:
+    PitchTrackWriter();
+    ~PitchTrackWriter();
+
+    bool open(const char* path, PitchTrackFormat format, int sampleRate, size_t hopSize, float tuningFreq);
+    void write(double time, const NoteInfo& note);
+    // Returns false if anything could not be written
+    bool close();
+
+private:
+    PitchTrackWriter(const PitchTrackWriter&);
+    PitchTrackWriter& operator=(const PitchTrackWriter&);
+
+    FILE* file;
+    PitchTrackFormat format;
+    float tuningFreq;
+    char* buffer;
+};
+
+#endif /* PitchTrack_HPP_ */
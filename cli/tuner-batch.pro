@@ -0,0 +1,47 @@
+# Headless batch analyser for recorded takes. Builds against Qt 4 on the desktop:
+#   qmake cli/tuner-batch.pro && make
+# KISSFFT points at the kissfft sources, by default next to this project like the
+# app expects them.
+
+TEMPLATE = app
+TARGET = tuner-batch
+CONFIG += console warn_on
+CONFIG -= app_bundle
+QT = core
+
+BASEDIR = $$quote($$_PRO_FILE_PWD_/..)
+isEmpty(KISSFFT): KISSFFT = $$quote($$BASEDIR/../kissfft)
+
+INCLUDEPATH += $$quote($$BASEDIR/src) \
+    $$quote($$BASEDIR/cli) \
+    $$quote($$KISSFFT/public) \
+    $$quote($$KISSFFT/src)
+
+SOURCES += \
+    $$quote($$BASEDIR/cli/batchworker.cpp) \
+    $$quote($$BASEDIR/cli/main.cpp) \
+    $$quote($$BASEDIR/cli/pitchtrack.cpp) \
+    $$quote($$BASEDIR/src/capturetrace.cpp) \
+    $$quote($$BASEDIR/src/fftpeakdetector.cpp) \
+    $$quote($$BASEDIR/src/fftplancache.cpp) \
+    $$quote($$BASEDIR/src/fftscalar.cpp) \
+    $$quote($$BASEDIR/src/fftspectrum.cpp) \
+    $$quote($$BASEDIR/src/fixedfft.cpp) \
+    $$quote($$BASEDIR/src/harmonicanalyser.cpp) \
+    $$quote($$BASEDIR/src/mappedaudiofile.cpp) \
+    $$quote($$BASEDIR/src/peakestimator.cpp) \
+    $$quote($$BASEDIR/src/phasevocoderdetector.cpp) \
+    $$quote($$BASEDIR/src/pitchanalyser.cpp) \
+    $$quote($$BASEDIR/src/pitchdetector.cpp) \
+    $$quote($$BASEDIR/src/pitchstabiliser.cpp) \
+    $$quote($$BASEDIR/src/resolutioncontroller.cpp) \
+    $$quote($$BASEDIR/src/spectralpeaks.cpp) \
+    $$quote($$BASEDIR/src/strobedetector.cpp) \
+    $$quote($$BASEDIR/src/windowing.cpp) \
+    $$quote($$BASEDIR/src/yindetector.cpp) \
+    $$quote($$BASEDIR/src/zoomfftdetector.cpp) \
+    $$quote($$KISSFFT/src/kiss_fft.c)
+
+HEADERS += \
+    $$quote($$BASEDIR/cli/batchworker.hpp) \
+    $$quote($$BASEDIR/cli/pitchtrack.hpp)
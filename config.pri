@@ -108,13 +108,85 @@ config_pri_assets {
 
 config_pri_source_group1 {
     SOURCES += \
+        $$quote($$BASEDIR/src/alsacapturebackend.cpp) \
+        $$quote($$BASEDIR/src/analysisscheduler.cpp) \
+        $$quote($$BASEDIR/src/analysisthread.cpp) \
         $$quote($$BASEDIR/src/applicationui.cpp) \
+        $$quote($$BASEDIR/src/capturebackend.cpp) \
+        $$quote($$BASEDIR/src/capturethread.cpp) \
+        $$quote($$BASEDIR/src/capturetrace.cpp) \
+        $$quote($$BASEDIR/src/fftpeakdetector.cpp) \
+        $$quote($$BASEDIR/src/fftplancache.cpp) \
+        $$quote($$BASEDIR/src/fftscalar.cpp) \
+        $$quote($$BASEDIR/src/fftspectrum.cpp) \
+        $$quote($$BASEDIR/src/fixedfft.cpp) \
+        $$quote($$BASEDIR/src/harmonicanalyser.cpp) \
+        $$quote($$BASEDIR/src/latencyhistogram.cpp) \
+        $$quote($$BASEDIR/src/latencymonitor.cpp) \
         $$quote($$BASEDIR/src/main.cpp) \
-        $$quote($$BASEDIR/src/soundprocessor.cpp)
+        $$quote($$BASEDIR/src/mappedaudiofile.cpp) \
+        $$quote($$BASEDIR/src/peakestimator.cpp) \
+        $$quote($$BASEDIR/src/phasevocoderdetector.cpp) \
+        $$quote($$BASEDIR/src/pitchanalyser.cpp) \
+        $$quote($$BASEDIR/src/pitchdetector.cpp) \
+        $$quote($$BASEDIR/src/pitchstabiliser.cpp) \
+        $$quote($$BASEDIR/src/qnxcapturebackend.cpp) \
+        $$quote($$BASEDIR/src/readingring.cpp) \
+        $$quote($$BASEDIR/src/recordingcapturebackend.cpp) \
+        $$quote($$BASEDIR/src/resolutioncontroller.cpp) \
+        $$quote($$BASEDIR/src/silencegate.cpp) \
+        $$quote($$BASEDIR/src/soundprocessor.cpp) \
+        $$quote($$BASEDIR/src/spectralpeaks.cpp) \
+        $$quote($$BASEDIR/src/strobedetector.cpp) \
+        $$quote($$BASEDIR/src/synthcapturebackend.cpp) \
+        $$quote($$BASEDIR/src/tracecapturebackend.cpp) \
+        $$quote($$BASEDIR/src/tunerviewmodel.cpp) \
+        $$quote($$BASEDIR/src/wavcapturebackend.cpp) \
+        $$quote($$BASEDIR/src/windowing.cpp) \
+        $$quote($$BASEDIR/src/yindetector.cpp) \
+        $$quote($$BASEDIR/src/zoomfftdetector.cpp)
 
     HEADERS += \
+        $$quote($$BASEDIR/src/alsacapturebackend.hpp) \
+        $$quote($$BASEDIR/src/analysisscheduler.hpp) \
+        $$quote($$BASEDIR/src/analysisthread.hpp) \
         $$quote($$BASEDIR/src/applicationui.hpp) \
-        $$quote($$BASEDIR/src/soundprocessor.hpp)
+        $$quote($$BASEDIR/src/capturebackend.hpp) \
+        $$quote($$BASEDIR/src/capturethread.hpp) \
+        $$quote($$BASEDIR/src/capturetrace.hpp) \
+        $$quote($$BASEDIR/src/fftpeakdetector.hpp) \
+        $$quote($$BASEDIR/src/fftplancache.hpp) \
+        $$quote($$BASEDIR/src/fftscalar.hpp) \
+        $$quote($$BASEDIR/src/fftspectrum.hpp) \
+        $$quote($$BASEDIR/src/fixedfft.hpp) \
+        $$quote($$BASEDIR/src/frametiming.hpp) \
+        $$quote($$BASEDIR/src/harmonicanalyser.hpp) \
+        $$quote($$BASEDIR/src/latencyhistogram.hpp) \
+        $$quote($$BASEDIR/src/latencymonitor.hpp) \
+        $$quote($$BASEDIR/src/mailbox.hpp) \
+        $$quote($$BASEDIR/src/mappedaudiofile.hpp) \
+        $$quote($$BASEDIR/src/noteinfo.hpp) \
+        $$quote($$BASEDIR/src/peakestimator.hpp) \
+        $$quote($$BASEDIR/src/phasevocoderdetector.hpp) \
+        $$quote($$BASEDIR/src/pitchanalyser.hpp) \
+        $$quote($$BASEDIR/src/pitchdetector.hpp) \
+        $$quote($$BASEDIR/src/pitchstabiliser.hpp) \
+        $$quote($$BASEDIR/src/qnxcapturebackend.hpp) \
+        $$quote($$BASEDIR/src/readingring.hpp) \
+        $$quote($$BASEDIR/src/recordingcapturebackend.hpp) \
+        $$quote($$BASEDIR/src/resolutioncontroller.hpp) \
+        $$quote($$BASEDIR/src/ringbuffer.hpp) \
+        $$quote($$BASEDIR/src/silencegate.hpp) \
+        $$quote($$BASEDIR/src/soundprocessor.hpp) \
+        $$quote($$BASEDIR/src/spectralpeaks.hpp) \
+        $$quote($$BASEDIR/src/strobedetector.hpp) \
+        $$quote($$BASEDIR/src/synthcapturebackend.hpp) \
+        $$quote($$BASEDIR/src/tracecapturebackend.hpp) \
+        $$quote($$BASEDIR/src/tunerviewmodel.hpp) \
+        $$quote($$BASEDIR/src/wavcapturebackend.hpp) \
+        $$quote($$BASEDIR/src/windowing.hpp) \
+        $$quote($$BASEDIR/src/yindetector.hpp) \
+        $$quote($$BASEDIR/src/zoomfftdetector.hpp)
 }
 
 INCLUDEPATH += $$quote($$BASEDIR/src)
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QtGlobal>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "readingring.hpp"
+#include "soundprocessor.hpp"
+
+static bool verbose = false;
+// Written to by the signal handler, the event loop quits when it becomes readable
+static int signalPipe[2];
+static volatile sig_atomic_t interrupted = 0;
+
+static void messageHandler(QtMsgType type, const char* message) {
+    if (type == QtDebugMsg && !verbose)
+        return;
+    fprintf(stderr, "%s\n", message);
+}
+
+static void onSignal(int) {
+    interrupted = 1;
+    char c = 0;
+    if (write(signalPipe[1], &c, 1) < 0) {
+        // Nothing to be done about it in a signal handler
+    }
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Runs capture and pitch analysis without a UI and publishes the readings, and\n"
+            "optionally their spectra, in shared memory for other local processes.\n"
+            "  -c SOURCE    capture source, as TUNER_CAPTURE (default pcmPreferred)\n"
+            "  -n N         channels to capture (default 1)\n"
+            "  -s NAME      shared memory object to publish in (default %s)\n"
+            "  -b N         spectrum bins per reading, 0 for none (default %d)\n"
+            "  -d DETECTOR  fft, yin, zoom, strobe or vocoder (default fft)\n"
+            "  -t NOTE      note to tune to with the strobe detector, as TUNER_TARGET\n"
+            "  -e METHOD    peak estimator of the fft detector (default %s)\n"
+            "  -r PATH      also record a capture trace\n"
+            "  -w           watch the readings of a running daemon instead\n"
+            "  -v           show the engine's debug output\n"
+            "Options given override the corresponding environment variables.\n",
+            program, READING_RING_DEFAULT_NAME, READING_RING_DEFAULT_BINS,
+            peakEstimatorName(PEAK_DEFAULT_ESTIMATOR));
+}
+
+// Prints what a running daemon publishes, as an example of a reader
+static int watch(const char* name) {
+    ReadingRingReader reader;
+    if (!reader.open(name)) {
+        fprintf(stderr, "No readings published in %s\n", name);
+        return EXIT_FAILURE;
+    }
+    printf("%d channels at %d Hz, up to %d spectrum bins\n", reader.channelCount(), reader.sampleRate(),
+            int(reader.spectrumBins()));
+
+    quint32 cursor = reader.published();
+    quint32 missed = 0;
+    ReadingRingView view;
+    while (!interrupted && reader.isAlive()) {
+        if (!reader.next(&cursor, &view, &missed)) {
+            usleep(5000);
+            continue;
+        }
+        NoteInfo note = *view.note;
+        float peakHz = 0;
+        for (size_t k = 1, peak = 0; k < view.spectrumBins; k++) {
+            if (view.spectrum[k] > view.spectrum[peak]) {
+                peak = k;
+                peakHz = k*view.binHz;
+            }
+        }
+        if (!reader.validate(view)) {
+            missed++;
+            continue;
+        }
+        qint64 age = monotonicMicros() - note.timing.captured;
+        printf("%u ch%d %-4s %+6.1f cents %8.2f Hz conf %.2f spectrum %d bins peak %.0f Hz age %.1f ms\n",
+                view.frame, note.channel, note.note[0] != 0 ? note.note : "-", note.centsDiff,
+                note.frequency, note.confidence, int(view.spectrumBins), peakHz, age/1000.0f);
+        fflush(stdout);
+    }
+    if (missed > 0)
+        fprintf(stderr, "Fell behind and missed %u readings\n", missed);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    qInstallMsgHandler(messageHandler);
+
+    const char* name = getenv("TUNER_PUBLISH");
+    bool watching = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:s:b:d:t:e:r:wv")) != -1) {
+        switch (opt) {
+        case 'c':
+            setenv("TUNER_CAPTURE", optarg, 1);
+            break;
+        case 'n':
+            setenv("TUNER_CHANNELS", optarg, 1);
+            break;
+        case 's':
+            name = optarg;
+            break;
+        case 'b':
+            setenv("TUNER_PUBLISH_BINS", optarg, 1);
+            break;
+        case 'd':
+            setenv("TUNER_DETECTOR", optarg, 1);
+            break;
+        case 't':
+            setenv("TUNER_TARGET", optarg, 1);
+            break;
+        case 'e':
+            setenv("TUNER_PEAK_ESTIMATOR", optarg, 1);
+            break;
+        case 'r':
+            setenv("TUNER_RECORD", optarg, 1);
+            break;
+        case 'w':
+            watching = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (name == NULL)
+        name = READING_RING_DEFAULT_NAME;
+
+    if (pipe(signalPipe) != 0)
+        return EXIT_FAILURE;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    if (watching)
+        return watch(name);
+
+    // The engine picks up its whole configuration from the environment, like the app
+    setenv("TUNER_PUBLISH", name, 1);
+    QCoreApplication app(argc, argv);
+    SoundProcessor processor;
+    if (!processor.isOpen() || !processor.isPublishing())
+        return EXIT_FAILURE;
+    fprintf(stderr, "Publishing readings of %d channels in %s\n", processor.channelCount(), name);
+
+    QSocketNotifier notifier(signalPipe[0], QSocketNotifier::Read);
+    QObject::connect(&notifier, SIGNAL(activated(int)), &app, SLOT(quit()));
+    app.exec();
+
+    fprintf(stderr, "%d overruns, %d frames dropped\n", processor.overrunCount(), processor.droppedFrameCount());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+# Headless tuner that publishes readings in shared memory for other processes, see
+# readingring.hpp. Builds against Qt 4 on the desktop, capturing through ALSA:
+#   qmake daemon/tuner-daemon.pro && make && ./tuner-daemon
+# KISSFFT points at the kissfft sources, by default next to this project like the
+# app expects them.
+
+TEMPLATE = app
+TARGET = tuner-daemon
+CONFIG += console warn_on
+CONFIG -= app_bundle
+QT = core
+
+BASEDIR = $$quote($$_PRO_FILE_PWD_/..)
+isEmpty(KISSFFT): KISSFFT = $$quote($$BASEDIR/../kissfft)
+
+INCLUDEPATH += $$quote($$BASEDIR/src) \
+    $$quote($$KISSFFT/public) \
+    $$quote($$KISSFFT/src)
+
+LIBS += -lasound
+linux: LIBS += -lrt
+
+SOURCES += \
+    $$quote($$BASEDIR/daemon/main.cpp) \
+    $$quote($$BASEDIR/src/alsacapturebackend.cpp) \
+    $$quote($$BASEDIR/src/analysisscheduler.cpp) \
+    $$quote($$BASEDIR/src/analysisthread.cpp) \
+    $$quote($$BASEDIR/src/capturebackend.cpp) \
+    $$quote($$BASEDIR/src/capturethread.cpp) \
+    $$quote($$BASEDIR/src/capturetrace.cpp) \
+    $$quote($$BASEDIR/src/fftpeakdetector.cpp) \
+    $$quote($$BASEDIR/src/fftplancache.cpp) \
+    $$quote($$BASEDIR/src/fftscalar.cpp) \
+    $$quote($$BASEDIR/src/fftspectrum.cpp) \
+    $$quote($$BASEDIR/src/fixedfft.cpp) \
+    $$quote($$BASEDIR/src/harmonicanalyser.cpp) \
+    $$quote($$BASEDIR/src/latencyhistogram.cpp) \
+    $$quote($$BASEDIR/src/latencymonitor.cpp) \
+    $$quote($$BASEDIR/src/mappedaudiofile.cpp) \
+    $$quote($$BASEDIR/src/peakestimator.cpp) \
+    $$quote($$BASEDIR/src/phasevocoderdetector.cpp) \
+    $$quote($$BASEDIR/src/pitchanalyser.cpp) \
+    $$quote($$BASEDIR/src/pitchdetector.cpp) \
+    $$quote($$BASEDIR/src/pitchstabiliser.cpp) \
+    $$quote($$BASEDIR/src/qnxcapturebackend.cpp) \
+    $$quote($$BASEDIR/src/readingring.cpp) \
+    $$quote($$BASEDIR/src/recordingcapturebackend.cpp) \
+    $$quote($$BASEDIR/src/resolutioncontroller.cpp) \
+    $$quote($$BASEDIR/src/silencegate.cpp) \
+    $$quote($$BASEDIR/src/soundprocessor.cpp) \
+    $$quote($$BASEDIR/src/spectralpeaks.cpp) \
+    $$quote($$BASEDIR/src/strobedetector.cpp) \
+    $$quote($$BASEDIR/src/synthcapturebackend.cpp) \
+    $$quote($$BASEDIR/src/tracecapturebackend.cpp) \
+    $$quote($$BASEDIR/src/wavcapturebackend.cpp) \
+    $$quote($$BASEDIR/src/windowing.cpp) \
+    $$quote($$BASEDIR/src/yindetector.cpp) \
+    $$quote($$BASEDIR/src/zoomfftdetector.cpp) \
+    $$quote($$KISSFFT/src/kiss_fft.c)
+
+# The QObjects, for moc
+HEADERS += \
+    $$quote($$BASEDIR/src/analysisthread.hpp) \
+    $$quote($$BASEDIR/src/capturethread.hpp) \
+    $$quote($$BASEDIR/src/soundprocessor.hpp)
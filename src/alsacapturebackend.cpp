@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "alsacapturebackend.hpp"
+
+#if defined(HAVE_ALSA_CAPTURE)
+
+#include <QtGlobal>
+#include <errno.h>
+#include <string.h>
+
+AlsaCaptureBackend::AlsaCaptureBackend(const char* device, int sampleRate, int channels, bool useMmap)
+    : rate(sampleRate), channels(channels), useMmap(useMmap) {
+    strncpy(this->device, device, sizeof(this->device) - 1);
+    this->device[sizeof(this->device) - 1] = 0;
+    pcmHandle = NULL;
+    periodSize = ALSA_PERIOD_SIZE;
+    fragBuff = NULL;
+}
+
+AlsaCaptureBackend::~AlsaCaptureBackend() {
+    close();
+}
+
+bool AlsaCaptureBackend::open() {
+    int rtn;
+    if ((rtn = snd_pcm_open(&pcmHandle, device, SND_PCM_STREAM_CAPTURE, 0)) < 0) {
+        qDebug("snd_pcm_open failed: %s\n", snd_strerror(rtn));
+        pcmHandle = NULL;
+        return false;
+    }
+
+    snd_pcm_hw_params_t* params;
+    snd_pcm_hw_params_alloca(&params);
+    snd_pcm_hw_params_any(pcmHandle, params);
+
+    snd_pcm_uframes_t bufferSize = ALSA_PERIOD_SIZE*ALSA_PERIODS;
+    periodSize = ALSA_PERIOD_SIZE;
+    if ((rtn = snd_pcm_hw_params_set_access(pcmHandle, params,
+                    useMmap ? SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED)) < 0
+            || (rtn = snd_pcm_hw_params_set_format(pcmHandle, params, SND_PCM_FORMAT_S16_LE)) < 0
+            || (rtn = snd_pcm_hw_params_set_channels(pcmHandle, params, channels)) < 0
+            || (rtn = snd_pcm_hw_params_set_rate_near(pcmHandle, params, &rate, NULL)) < 0
+            || (rtn = snd_pcm_hw_params_set_period_size_near(pcmHandle, params, &periodSize, NULL)) < 0
+            || (rtn = snd_pcm_hw_params_set_buffer_size_near(pcmHandle, params, &bufferSize)) < 0
+            || (rtn = snd_pcm_hw_params(pcmHandle, params)) < 0) {
+        qDebug("Setting ALSA hardware parameters failed: %s\n", snd_strerror(rtn));
+        close();
+        return false;
+    }
+    snd_pcm_hw_params_get_period_size(params, &periodSize, NULL);
+
+    if ((rtn = snd_pcm_prepare(pcmHandle)) < 0 || (rtn = snd_pcm_start(pcmHandle)) < 0) {
+        qDebug("Starting ALSA capture failed: %s\n", snd_strerror(rtn));
+        close();
+        return false;
+    }
+
+    if (!useMmap)
+        fragBuff = new short[periodSize*channels];
+    return true;
+}
+
+void AlsaCaptureBackend::close() {
+    if (pcmHandle != NULL) {
+        snd_pcm_close(pcmHandle);
+        pcmHandle = NULL;
+    }
+    delete[] fragBuff;
+    fragBuff = NULL;
+}
+
+bool AlsaCaptureBackend::pause() {
+    int rtn;
+    if ((rtn = snd_pcm_drop(pcmHandle)) < 0) {
+        qDebug("snd_pcm_drop failed: %s\n", snd_strerror(rtn));
+        return false;
+    }
+    return true;
+}
+
+bool AlsaCaptureBackend::resume() {
+    int rtn;
+    if ((rtn = snd_pcm_prepare(pcmHandle)) < 0 || (rtn = snd_pcm_start(pcmHandle)) < 0) {
+        qDebug("Restarting ALSA capture failed: %s\n", snd_strerror(rtn));
+        return false;
+    }
+    return true;
+}
+
+int AlsaCaptureBackend::overrunCount() const {
+    return overruns.fetchAndAddRelaxed(0);
+}
+
+int AlsaCaptureBackend::capture(RingBuffer<short>* const* samples, int timeoutUs) {
+    int rtn = snd_pcm_wait(pcmHandle, timeoutUs/1000);
+    if (rtn == 0)
+        return 0;
+    if (rtn < 0)
+        return recover(rtn) ? 0 : -1;
+
+    return useMmap ? captureMmap(samples) : captureRead(samples);
+}
+
+int AlsaCaptureBackend::captureMmap(RingBuffer<short>* const* samples) {
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(pcmHandle);
+    if (avail < 0)
+        return recover(int(avail)) ? 0 : -1;
+
+    // At most a period per call, as fragmentSize() promises, the rest is still
+    // available to the next one
+    if (snd_pcm_uframes_t(avail) > periodSize)
+        avail = snd_pcm_sframes_t(periodSize);
+    int captured = 0;
+    while (avail > 0) {
+        const snd_pcm_channel_area_t* areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = snd_pcm_uframes_t(avail);
+        int rtn;
+        if ((rtn = snd_pcm_mmap_begin(pcmHandle, &areas, &offset, &frames)) < 0)
+            return recover(rtn) ? captured : -1;
+
+        // Interleaved, so each channel's area is every step bits from its first sample
+        for (unsigned int c = 0; c < channels; c++) {
+            const short* data = (const short*)((const char*)areas[c].addr + (areas[c].first + offset*areas[c].step)/8);
+            samples[c]->writeStrided(data, frames, areas[c].step/16);
+        }
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcmHandle, offset, frames);
+        if (committed < 0 || snd_pcm_uframes_t(committed) != frames)
+            return recover(committed < 0 ? int(committed) : -EPIPE) ? captured + int(frames) : -1;
+
+        captured += int(frames);
+        avail -= snd_pcm_sframes_t(frames);
+    }
+    return captured;
+}
+
+int AlsaCaptureBackend::captureRead(RingBuffer<short>* const* samples) {
+    snd_pcm_sframes_t frames = snd_pcm_readi(pcmHandle, fragBuff, periodSize);
+    if (frames < 0)
+        return recover(int(frames)) ? 0 : -1;
+
+    // Append read samples to the ring buffers, the oldest samples get overwritten
+    writeInterleaved(fragBuff, size_t(frames), int(channels), samples, int(channels));
+    return int(frames);
+}
+
+bool AlsaCaptureBackend::recover(int err) {
+    if (err == -EPIPE)
+        overruns.ref();
+
+    int rtn;
+    if ((rtn = snd_pcm_recover(pcmHandle, err, 1)) < 0) {
+        qDebug("snd_pcm_recover failed: %s\n", snd_strerror(rtn));
+        return false;
+    }
+    // Capture streams have to be restarted explicitly after they were re-prepared
+    if (snd_pcm_state(pcmHandle) == SND_PCM_STATE_PREPARED && (rtn = snd_pcm_start(pcmHandle)) < 0) {
+        qDebug("snd_pcm_start failed: %s\n", snd_strerror(rtn));
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AlsaCaptureBackend_HPP_
+#define AlsaCaptureBackend_HPP_
+
+#if defined(__linux__)
+#define HAVE_ALSA_CAPTURE
+
+#include <QAtomicInt>
+#include <alsa/asoundlib.h>
+#include "capturebackend.hpp"
+
+// Requested period, the driver may round it
+#define ALSA_PERIOD_SIZE 1024
+#define ALSA_PERIODS 4
+
+/*
+ * Linux ALSA capture. In mmap mode samples are copied from the driver's buffer straight
+ * into the sample ring buffers between snd_pcm_mmap_begin() and snd_pcm_mmap_commit(),
+ * one channel at a time, so there is no staging buffer. Read mode goes through snd_pcm_readi() and a fragment
+ * buffer like the QNX backend does, which is there to compare the two.
+ */
+class AlsaCaptureBackend : public CaptureBackend {
+public:
+    AlsaCaptureBackend(const char* device, int sampleRate, int channels, bool useMmap);
+    virtual ~AlsaCaptureBackend();
+
+    virtual const char* name() const { return useMmap ? "alsa-mmap" : "alsa-read"; }
+    virtual bool open();
+    virtual void close();
+    virtual bool pause();
+    virtual bool resume();
+    virtual int sampleRate() const { return rate; }
+    virtual int channelCount() const { return int(channels); }
+    virtual size_t fragmentSize() const { return periodSize; }
+    virtual int capture(RingBuffer<short>* const* samples, int timeoutUs);
+    virtual int overrunCount() const;
+
+private:
+    AlsaCaptureBackend(const AlsaCaptureBackend&);
+    AlsaCaptureBackend& operator=(const AlsaCaptureBackend&);
+
+    int captureMmap(RingBuffer<short>* const* samples);
+    int captureRead(RingBuffer<short>* const* samples);
+    bool recover(int err);
+
+    char device[64];
+    unsigned int rate;
+    unsigned int channels;
+    bool useMmap;
+    snd_pcm_t* pcmHandle;
+    snd_pcm_uframes_t periodSize;
+    short* fragBuff;
+
+    mutable QAtomicInt overruns;
+};
+
+#endif
+
+#endif /* AlsaCaptureBackend_HPP_ */
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analysisscheduler.hpp"
+
+#include <QMutexLocker>
+#include <QtGlobal>
+
+AnalysisScheduler::AnalysisScheduler(int sampleRate, size_t frameSize)
+    : sampleRate(sampleRate), frameSize(frameSize) {
+    budget = DEFAULT_ANALYSIS_BUDGET;
+    overlap = -1;
+    meanAnalysisTime = 0;
+    lastAnalysed = 0;
+    requestedHop = 1;
+    setTargetRate(DEFAULT_UPDATE_RATE);
+}
+
+void AnalysisScheduler::setHopSamples(size_t hop) {
+    setRequestedHop(hop);
+}
+
+void AnalysisScheduler::setHopMs(float ms) {
+    setRequestedHop(size_t(ms*sampleRate/1000));
+}
+
+void AnalysisScheduler::setOverlap(float percent) {
+    QMutexLocker locker(&mutex);
+    overlap = qBound(0.0f, percent, 99.0f);
+    applyRequestedHop(size_t(frameSize*(100 - overlap)/100));
+}
+
+void AnalysisScheduler::setTargetRate(float hz) {
+    if (hz > 0)
+        setRequestedHop(size_t(sampleRate/hz));
+}
+
+void AnalysisScheduler::setBudget(float fraction) {
+    QMutexLocker locker(&mutex);
+    budget = qBound(0.05f, fraction, 1.0f);
+}
+
+void AnalysisScheduler::setFrameSize(size_t size) {
+    QMutexLocker locker(&mutex);
+    if (size == frameSize)
+        return;
+    frameSize = size;
+    if (overlap >= 0)
+        applyRequestedHop(size_t(frameSize*(100 - overlap)/100));
+}
+
+void AnalysisScheduler::setRequestedHop(size_t size) {
+    QMutexLocker locker(&mutex);
+    overlap = -1;
+    applyRequestedHop(size);
+}
+
+void AnalysisScheduler::applyRequestedHop(size_t size) {
+    requestedHop = qMax(size, size_t(1));
+    hop.fetchAndStoreRelease(int(requestedHop));
+}
+
+size_t AnalysisScheduler::requestedHopSize() const {
+    QMutexLocker locker(&mutex);
+    return requestedHop;
+}
+
+size_t AnalysisScheduler::hopSize() const {
+    return size_t(hop.fetchAndAddAcquire(0));
+}
+
+float AnalysisScheduler::analysisTime() const {
+    QMutexLocker locker(&mutex);
+    return meanAnalysisTime;
+}
+
+bool AnalysisScheduler::shouldAnalyse(unsigned int written) {
+    if (written - lastAnalysed < (unsigned int)hopSize())
+        return false;
+
+    // Restart from the current position rather than catching up on missed hops
+    lastAnalysed = written;
+    return true;
+}
+
+void AnalysisScheduler::restart(unsigned int written) {
+    lastAnalysed = written;
+}
+
+void AnalysisScheduler::recordAnalysisTime(float seconds) {
+    QMutexLocker locker(&mutex);
+    if (meanAnalysisTime == 0)
+        meanAnalysisTime = seconds;
+    else
+        meanAnalysisTime += ANALYSIS_TIME_SMOOTHING*(seconds - meanAnalysisTime);
+
+    // Shortest hop whose budget still covers the analysis, never below the requested
+    // hop and never longer than a second
+    size_t current = size_t(hop.fetchAndAddRelaxed(0));
+    size_t affordable = size_t(meanAnalysisTime*sampleRate/budget);
+    size_t target = qBound(requestedHop, affordable, qMax(requestedHop, size_t(sampleRate)));
+
+    // Stretch straight away, shrink only once there is a clear margin (or the requested
+    // hop fits again) so the update rate does not flip between two values
+    if (target > current || target < current*4/5 || target == requestedHop)
+        hop.fetchAndStoreRelease(int(target));
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AnalysisScheduler_HPP_
+#define AnalysisScheduler_HPP_
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <stddef.h>
+
+#define DEFAULT_UPDATE_RATE 30.0f
+// Share of a hop the analysis may take before the hop gets stretched
+#define DEFAULT_ANALYSIS_BUDGET 0.75f
+// Smoothing factor for the measured analysis time
+#define ANALYSIS_TIME_SMOOTHING 0.2f
+
+/*
+ * Decides when the next analysis is due, in samples rather than fragments, so the update
+ * rate does not depend on the fragment size the driver picked. The hop can be given
+ * directly, in milliseconds, as an overlap between consecutive frames or as an update
+ * rate. An overlap keeps applying when the frame size changes, e.g. with the detector
+ * or the FFT size the register calls for, the other forms fix the hop. When the measured analysis time exceeds its budget the hop is stretched until
+ * it fits, and it returns to the requested hop once analysis gets faster again.
+ *
+ * shouldAnalyse() is called from the capture thread and recordAnalysisTime() from the
+ * analysis thread. Analyses can only start at fragment boundaries, so hops shorter than
+ * a fragment are rounded up to one fragment.
+ */
+class AnalysisScheduler {
+public:
+    AnalysisScheduler(int sampleRate, size_t frameSize);
+
+    void setHopSamples(size_t hop);
+    void setHopMs(float ms);
+    void setOverlap(float percent);
+    void setTargetRate(float hz);
+    void setBudget(float fraction);
+    // Rederives the hop if it was given as an overlap
+    void setFrameSize(size_t frameSize);
+
+    size_t requestedHopSize() const;
+    size_t hopSize() const;
+    float analysisTime() const;
+
+    bool shouldAnalyse(unsigned int written);
+    // Counts the next hop from written, after an analysis that was started out of turn
+    void restart(unsigned int written);
+    void recordAnalysisTime(float seconds);
+
+private:
+    void setRequestedHop(size_t hop);
+    // With the mutex held
+    void applyRequestedHop(size_t hop);
+
+    int sampleRate;
+
+    mutable QMutex mutex;
+    size_t frameSize;
+    float budget;
+    // Negative unless the hop was given as an overlap
+    float overlap;
+    size_t requestedHop;
+    float meanAnalysisTime;
+    mutable QAtomicInt hop;
+
+    // Capture thread only
+    unsigned int lastAnalysed;
+};
+
+#endif /* AnalysisScheduler_HPP_ */
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analysisthread.hpp"
+
+#include <QMutexLocker>
+
+AnalysisThread::AnalysisThread(const QList<AnalysisChannel>& channels, AnalysisScheduler* scheduler,
+        SilenceGate* gate, LatencyMonitor* monitor, QObject* parent)
+    : QThread(parent), channels(channels), scheduler(scheduler), gate(gate), monitor(monitor) {
+    readings = new Mailbox<NoteInfo>[channels.size()];
+    pending = false;
+    stopping = false;
+    lastCaptured = 0;
+    gated = false;
+    publisher = NULL;
+}
+
+AnalysisThread::~AnalysisThread() {
+    stop();
+    delete[] readings;
+}
+
+void AnalysisThread::requestAnalysis(qint64 captured, bool gated) {
+    QMutexLocker locker(&mutex);
+    // The pending analysis will see these samples too, so it is timed from them, and
+    // whether it is gated is up to the newest request
+    lastCaptured = captured;
+    this->gated = gated;
+    if (pending) {
+        // The worker has not caught up with the previous request yet
+        droppedFrames.ref();
+        monitor->count(DroppedFrameCounter);
+        return;
+    }
+    pending = true;
+    requested.wakeOne();
+}
+
+void AnalysisThread::stop() {
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        requested.wakeOne();
+    }
+    wait();
+}
+
+bool AnalysisThread::takeReading(int index, NoteInfo* note) {
+    return readings[index].take(note);
+}
+
+int AnalysisThread::droppedFrameCount() const {
+    return droppedFrames.fetchAndAddRelaxed(0);
+}
+
+int AnalysisThread::droppedReadingCount() const {
+    int dropped = 0;
+    for (int i = 0; i < channels.size(); i++)
+        dropped += readings[i].replacedCount();
+    return dropped;
+}
+
+void AnalysisThread::run() {
+    FrameTiming timing;
+    bool gatedRequest;
+    forever {
+        {
+            QMutexLocker locker(&mutex);
+            while (!pending && !stopping)
+                requested.wait(&mutex);
+            if (stopping)
+                break;
+            pending = false;
+            timing.captured = lastCaptured;
+            gatedRequest = gated;
+        }
+
+        if (gatedRequest) {
+            postGated(timing);
+            continue;
+        }
+
+        qint64 started = monotonicMicros();
+        bool notify = false;
+        for (int i = 0; i < channels.size(); i++) {
+            const AnalysisChannel& channel = channels[i];
+            timing.analysisStarted = monotonicMicros();
+            NoteInfo note = channel.analyser->getNote(channel.samples);
+            timing.analysisFinished = monotonicMicros();
+
+            note.channel = channel.channel;
+            note.timing = timing;
+            monitor->recordAnalysis(timing);
+            monitor->count(ReadingCounter);
+            if (note.note[0] == 0)
+                monitor->count(channel.analyser->silentReadings() > 0 ? SilentReadingCounter : UnstableReadingCounter);
+            else
+                gate->reportPitch();
+
+            if (publisher != NULL) {
+                size_t bins = 0;
+                float binHz = 0;
+                const float* power = channel.analyser->powerSpectrum(&bins, &binHz);
+                publisher->publish(note, power, bins, binHz);
+            }
+            if (readings[i].post(note))
+                notify = true;
+            else
+                monitor->count(DroppedReadingCounter);
+        }
+        // The hop has to leave room for all of this thread's channels
+        scheduler->recordAnalysisTime((monotonicMicros() - started)/1000000.0f);
+        // A hop given as an overlap follows the frame of the first channel, whose size
+        // changes with the register being played
+        if (channels[0].channel == 0)
+            scheduler->setFrameSize(channels[0].analyser->frameSize());
+
+        if (notify)
+            emit readingAvailable();
+    }
+}
+
+void AnalysisThread::postGated(FrameTiming timing) {
+    bool notify = false;
+    timing.analysisStarted = timing.analysisFinished = monotonicMicros();
+    for (int i = 0; i < channels.size(); i++) {
+        NoteInfo note = channels[i].analyser->gatedNote();
+        note.channel = channels[i].channel;
+        note.timing = timing;
+        monitor->count(GatedReadingCounter);
+        if (publisher != NULL)
+            publisher->publish(note);
+        if (readings[i].post(note))
+            notify = true;
+        else
+            monitor->count(DroppedReadingCounter);
+    }
+    if (notify)
+        emit readingAvailable();
+}
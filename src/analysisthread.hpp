@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AnalysisThread_HPP_
+#define AnalysisThread_HPP_
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include "analysisscheduler.hpp"
+#include "latencymonitor.hpp"
+#include "mailbox.hpp"
+#include "noteinfo.hpp"
+#include "pitchanalyser.hpp"
+#include "readingring.hpp"
+#include "ringbuffer.hpp"
+#include "silencegate.hpp"
+
+// One capture channel and the analyser listening to it
+struct AnalysisChannel {
+    int channel;
+    PitchAnalyser* analyser;
+    const RingBuffer<short>* samples;
+};
+
+/*
+ * Runs pitch analysis on its own thread, for one or more capture channels. The capture
+ * thread requests an analysis once enough new samples have arrived; a request that comes
+ * in while the previous one is still pending is dropped rather than queued, so analysis
+ * always works on the newest window. Each request analyses all of the thread's channels
+ * in turn. Results go into a latest-wins mailbox per channel and readingAvailable() is
+ * emitted when one of them goes from empty to full.
+ *
+ * Requests the silence gate marks as gated skip the detectors and post blank readings,
+ * and readings that find a pitch are reported back to the gate. With a publisher every
+ * reading is also published, with the spectrum it came from, straight from this thread.
+ *
+ * With several channels there is one thread per core, each with its own share of the
+ * channels. Their analysers draw FFT plans and window tables from the shared caches, so
+ * only the working buffers are per channel.
+ */
+class AnalysisThread : public QThread {
+    Q_OBJECT
+
+public:
+    AnalysisThread(const QList<AnalysisChannel>& channels, AnalysisScheduler* scheduler,
+            SilenceGate* gate, LatencyMonitor* monitor, QObject* parent = 0);
+    virtual ~AnalysisThread();
+
+    // Called with the time the newest samples were captured. A gated request only
+    // blanks the readings.
+    void requestAnalysis(qint64 captured, bool gated = false);
+    void stop();
+    // Before the thread is started
+    void setPublisher(ReadingRingWriter* publisher) { this->publisher = publisher; }
+
+    int channelCount() const { return channels.size(); }
+    // Takes the reading of the thread's index-th channel, see NoteInfo::channel for
+    // the capture channel it came from
+    bool takeReading(int index, NoteInfo* note);
+    int droppedFrameCount() const;
+    int droppedReadingCount() const;
+
+Q_SIGNALS:
+    void readingAvailable();
+
+protected:
+    virtual void run();
+
+private:
+    void postGated(FrameTiming timing);
+
+private:
+    QList<AnalysisChannel> channels;
+    AnalysisScheduler* scheduler;
+    SilenceGate* gate;
+    LatencyMonitor* monitor;
+    Mailbox<NoteInfo>* readings;
+    ReadingRingWriter* publisher;
+
+    QMutex mutex;
+    QWaitCondition requested;
+    bool pending;
+    bool stopping;
+    // When the newest samples the next analysis will see were captured
+    qint64 lastCaptured;
+    bool gated;
+
+    mutable QAtomicInt droppedFrames;
+};
+
+#endif /* AnalysisThread_HPP_ */
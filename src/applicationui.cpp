@@ -17,7 +17,6 @@
 #include "applicationui.hpp"
 
 #include <bb/cascades/Application>
-#include <bb/cascades/Label>
 #include <bb/cascades/QmlDocument>
 #include <bb/cascades/AbstractPane>
 #include <bb/cascades/LocaleHandler>
@@ -38,8 +37,10 @@ ApplicationUI::ApplicationUI() : QObject()
     // initial load
     onSystemLanguageChanged();
 
-    // Create the main scene
+    // Create the main scene, its labels bind to the view model
+    viewModel = new TunerViewModel(this);
     QmlDocument* qml = QmlDocument::create("asset:///qml/main.qml").parent(this);
+    qml->setContextProperty("tuner", viewModel);
 
     // Create root object for the UI
     AbstractPane *root = qml->createRootObject<AbstractPane>();
@@ -54,21 +55,33 @@ ApplicationUI::ApplicationUI() : QObject()
 }
 
 void ApplicationUI::stopSoundCapture() {
-    if (soundProcessor != NULL) {
-        qDebug("Sound capture will stop");
-        QObject::disconnect(soundProcessor, SIGNAL(readingUpdated(SoundProcessor::NoteInfo)), this,
-                    SLOT(onReadingUpdated(SoundProcessor::NoteInfo)));
-        delete soundProcessor;
-        soundProcessor = NULL;
+    // The processor is kept, so that coming back only has to restart the capture
+    // channel rather than reallocate and relearn everything
+    if (soundProcessor != NULL && !soundProcessor->isPaused()) {
+        qDebug("Sound capture will pause");
+        soundProcessor->pause();
     }
 }
 
 void ApplicationUI::startSoundCapture() {
+    // A processor that could not open the microphone is retried from scratch
+    if (soundProcessor != NULL && !soundProcessor->isOpen()) {
+        viewModel->setLatencyMonitor(NULL);
+        viewModel->setPitchTrack(NULL, 0, 0);
+        delete soundProcessor;
+        soundProcessor = NULL;
+    }
     if (soundProcessor == NULL) {
         qDebug("Sound capture will start");
-        soundProcessor = new SoundProcessor();
+        soundProcessor = new SoundProcessor(this);
         QObject::connect(soundProcessor, SIGNAL(readingUpdated(SoundProcessor::NoteInfo)), this,
             SLOT(onReadingUpdated(SoundProcessor::NoteInfo)));
+        viewModel->setLatencyMonitor(soundProcessor->latencyMonitor());
+        viewModel->setPitchTrack(soundProcessor->pitchTrack(0), soundProcessor->sampleRateHz(),
+                soundProcessor->pitchTrackHop());
+    } else if (soundProcessor->isPaused()) {
+        qDebug("Sound capture will resume");
+        soundProcessor->resume();
     }
 }
 
@@ -93,74 +106,9 @@ void ApplicationUI::onAwake() {
 }
 
 void ApplicationUI::onReadingUpdated(SoundProcessor::NoteInfo note) {
-    QString readableNote(note.note);
-    QString readableCents;
-    readableCents.sprintf("%c%d\n", (note.centsDiff < 0? '-' : '+'), (int)fabs(note.centsDiff));
-
-    Label* noteLabel = Application::instance()->findChild<Label*>("noteLabel");
-    Label* offsetVisualLabel = Application::instance()->findChild<Label*>("tuneOffsetLabel");
-    Label* offsetCentsLabel = Application::instance()->findChild<Label*>("tuneCentsOffsetLabel");
-
-    if (noteLabel == NULL || offsetCentsLabel == NULL || offsetVisualLabel == NULL)
-       return;
-
-    // Human-readable note name
-    if (readableNote.isEmpty()) {
-        noteLabel->setText(QObject::tr("I'm listening..."));
-    } else {
-        noteLabel->setText(readableNote);
-    }
-
-    // Human-readable tuning offset in cents
-    if (!readableCents.isEmpty() && !readableNote.isEmpty())
-        offsetCentsLabel->setText(readableCents);
-    else
-        offsetCentsLabel->setText("");
-
-    // Visual tuning offset using coloured circles
-    QString flatIndicatorBigDiff = "";
-    QString flatIndicatorSmallDiff = "";
-    QString inTuneIndicator = "";
-    QString sharpIndicatorSmallDiff = "";
-    QString sharpIndicatorBigDiff = "";
-
-    QString neutralIndicatorSpan = "<span style=\"color:#ffeee8d5\">n</span>";
-    QString bigDiffIndicatorSpan = "<span style=\"color:#ffdc322f\">n</span>";
-    QString smallDiffIndicatorSpan = "<span style=\"color:#ffb58900\">n</span>";
-    QString inTuneIndicatorSpan = "<span style=\"color:#ff2aa198\">n</span>";
-
-    int bigDiff = 25;
-    int smallDiff = 5;
-
-    if (note.centsDiff <= -1*bigDiff)
-        flatIndicatorBigDiff += bigDiffIndicatorSpan;
-    else
-        flatIndicatorBigDiff += neutralIndicatorSpan;
-
-    if (note.centsDiff > -1*bigDiff && note.centsDiff <= -1*smallDiff)
-        flatIndicatorSmallDiff += smallDiffIndicatorSpan;
-    else
-        flatIndicatorSmallDiff += neutralIndicatorSpan;
-
-    if (note.centsDiff > -1*smallDiff && note.centsDiff < smallDiff)
-        inTuneIndicator += inTuneIndicatorSpan;
-    else
-        inTuneIndicator += neutralIndicatorSpan;
-
-    if (note.centsDiff < bigDiff && note.centsDiff > smallDiff)
-        sharpIndicatorSmallDiff += smallDiffIndicatorSpan;
-    else
-        sharpIndicatorSmallDiff += neutralIndicatorSpan;
-
-    if (note.centsDiff >= bigDiff)
-        sharpIndicatorBigDiff += bigDiffIndicatorSpan;
-    else
-        sharpIndicatorBigDiff += neutralIndicatorSpan;
-
-    QString status = flatIndicatorBigDiff + " " + flatIndicatorSmallDiff + " "
-            + inTuneIndicator + " " + sharpIndicatorSmallDiff + " " + sharpIndicatorBigDiff;
-
-    offsetVisualLabel->setText(status);
+    // There is only one display, it shows the first channel
+    if (note.channel == 0)
+        viewModel->updateReading(note);
 }
 
 void ApplicationUI::onSystemLanguageChanged()
@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include "soundprocessor.hpp"
+#include "tunerviewmodel.hpp"
 
 namespace bb
 {
@@ -47,6 +48,7 @@ private:
     QTranslator* m_pTranslator;
     bb::cascades::LocaleHandler* m_pLocaleHandler;
     SoundProcessor* soundProcessor;
+    TunerViewModel* viewModel;
     void startSoundCapture();
     void stopSoundCapture();
 };
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "capturebackend.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "alsacapturebackend.hpp"
+#include "qnxcapturebackend.hpp"
+#include "synthcapturebackend.hpp"
+#include "tracecapturebackend.hpp"
+#include "wavcapturebackend.hpp"
+
+CapturePacer::CapturePacer() : sampleRate(DEFAULT_SAMPLE_RATE), delivered(0) {
+    memset(&started, 0, sizeof(started));
+}
+
+void CapturePacer::start(int sampleRate) {
+    this->sampleRate = sampleRate;
+    delivered = 0;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+}
+
+bool CapturePacer::wait(size_t n, int timeoutUs) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = double(now.tv_sec - started.tv_sec) + double(now.tv_nsec - started.tv_nsec)/1000000000;
+    double due = double(delivered + n)/sampleRate;
+
+    if (due > elapsed) {
+        double waitUs = (due - elapsed)*1000000;
+        if (waitUs > timeoutUs) {
+            usleep(timeoutUs);
+            return false;
+        }
+        usleep(useconds_t(waitUs));
+    }
+    delivered += n;
+    return true;
+}
+
+void writeInterleaved(const short* frames, size_t n, int frameSize,
+        RingBuffer<short>* const* channels, int channelCount) {
+    for (int c = 0; c < channelCount; c++)
+        channels[c]->writeStrided(&frames[c], n, frameSize);
+}
+
+CaptureBackend* createCaptureBackend(const char* description, int channels) {
+    if (description == NULL)
+        description = "pcmPreferred";
+    if (channels < 1)
+        channels = 1;
+
+    if (strncmp(description, "wav:", 4) == 0)
+        return new WavCaptureBackend(&description[4], true, channels);
+    if (strncmp(description, "trace:", 6) == 0)
+        return new TraceCaptureBackend(&description[6], true, channels);
+    if (strncmp(description, "trace-fast:", 11) == 0)
+        return new TraceCaptureBackend(&description[11], false, channels);
+    if (strncmp(description, "tone:", 5) == 0) {
+        QList<float> frequencies;
+        const char* f = &description[5];
+        do {
+            frequencies.append(float(atof(f)));
+            f = strchr(f, ',');
+        } while (f++ != NULL);
+        return new SynthCaptureBackend(DEFAULT_SAMPLE_RATE, frequencies);
+    }
+#if defined(HAVE_ALSA_CAPTURE)
+    if (strncmp(description, "alsa:", 5) == 0)
+        return new AlsaCaptureBackend(&description[5], DEFAULT_SAMPLE_RATE, channels, true);
+    if (strncmp(description, "alsa-read:", 10) == 0)
+        return new AlsaCaptureBackend(&description[10], DEFAULT_SAMPLE_RATE, channels, false);
+#endif
+
+#if defined(HAVE_QNX_CAPTURE)
+    return new QnxCaptureBackend(description, DEFAULT_SAMPLE_RATE, channels);
+#elif defined(HAVE_ALSA_CAPTURE)
+    return new AlsaCaptureBackend(strcmp(description, "pcmPreferred") == 0 ? "default" : description,
+            DEFAULT_SAMPLE_RATE, channels, true);
+#else
+    return NULL;
+#endif
+}
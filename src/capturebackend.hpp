@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CaptureBackend_HPP_
+#define CaptureBackend_HPP_
+
+#include <stddef.h>
+#include <time.h>
+#include "ringbuffer.hpp"
+
+#define DEFAULT_SAMPLE_RATE 44100
+// Samples per fragment for backends that get to choose it
+#define DEFAULT_FRAGMENT_SIZE 1024
+
+/*
+ * Source of 16 bit samples for the capture thread, one or more channels of them.
+ * capture() waits a bounded time for the next fragment and appends each channel to its
+ * own sample ring buffer, so backends that can hand out the driver's buffer copy
+ * straight from there without a staging buffer. Overruns are recovered from inside the
+ * backend and only counted.
+ */
+class CaptureBackend {
+public:
+    virtual ~CaptureBackend() {}
+
+    virtual const char* name() const = 0;
+
+    // Returns false if the device or file could not be opened
+    virtual bool open() = 0;
+    virtual void close() = 0;
+
+    // Stop the device from delivering samples without closing it, and start it again
+    // where it left off, which is much cheaper than reopening it. Never called while
+    // capture() runs. Backends that pace themselves pick up the pacing from the resume.
+    virtual bool pause() = 0;
+    virtual bool resume() = 0;
+
+    // Valid after open()
+    virtual int sampleRate() const = 0;
+    // Channels delivered by capture(), which can be fewer than were asked for
+    virtual int channelCount() const = 0;
+    // Most samples per channel a single capture() appends
+    virtual size_t fragmentSize() const = 0;
+
+    // Appends whatever arrives within timeoutUs to the ring buffers, one for each of
+    // channelCount() channels. Returns the number of samples appended per channel, 0 on
+    // timeout and -1 at the end of the stream or on an error the backend cannot recover
+    // from. Capture thread only.
+    virtual int capture(RingBuffer<short>* const* samples, int timeoutUs) = 0;
+
+    virtual int overrunCount() const = 0;
+};
+
+/*
+ * Paces backends that generate or read samples faster than real time, so that they
+ * deliver them at the rate a capture device would.
+ */
+class CapturePacer {
+public:
+    CapturePacer();
+
+    void start(int sampleRate);
+    // Waits at most timeoutUs for the next n samples to become due. Returns false if
+    // they are not due yet.
+    bool wait(size_t n, int timeoutUs);
+
+private:
+    int sampleRate;
+    struct timespec started;
+    unsigned long long delivered;
+};
+
+// Appends the first channelCount channels of n interleaved frames of frameSize samples
+// each to their ring buffers
+void writeInterleaved(const short* frames, size_t n, int frameSize,
+        RingBuffer<short>* const* channels, int channelCount);
+
+// Creates a backend from a description: "wav:<path>", "tone:<frequency>[,<frequency>...]"
+// with one channel per frequency, "trace:<path>" or "trace-fast:<path>" to replay a
+// capture trace at its original timing or as fast as possible, "alsa:<device>",
+// "alsa-read:<device>" or the name of a platform capture device. Devices and files are asked for the given number of
+// channels. Returns NULL if the description names a backend this platform does not have.
+CaptureBackend* createCaptureBackend(const char* description, int channels = 1);
+
+#endif /* CaptureBackend_HPP_ */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "capturethread.hpp"
+
+#include <QMutexLocker>
+
+CaptureThread::CaptureThread(CaptureBackend* backend, RingBuffer<short>* const* samples,
+        AnalysisScheduler* scheduler, const QList<AnalysisThread*>& analysis,
+        SilenceGate* gate, LatencyMonitor* monitor, QObject* parent)
+    : QThread(parent), backend(backend), samples(samples), scheduler(scheduler), analysis(analysis),
+      gate(gate), monitor(monitor), parked(false) {
+}
+
+CaptureThread::~CaptureThread() {
+    stop();
+}
+
+void CaptureThread::stop() {
+    stopping.fetchAndStoreOrdered(1);
+    pauseMutex.lock();
+    pauseChanged.wakeAll();
+    pauseMutex.unlock();
+    wait();
+}
+
+void CaptureThread::pause() {
+    QMutexLocker locker(&pauseMutex);
+    pauseRequested.fetchAndStoreOrdered(1);
+    // The thread parks once the capture() in progress has returned, which is within the
+    // poll timeout
+    while (!parked && isRunning())
+        pauseChanged.wait(&pauseMutex, CAPTURE_POLL_TIMEOUT_US/1000);
+    locker.unlock();
+    backend->pause();
+}
+
+void CaptureThread::resume() {
+    backend->resume();
+    QMutexLocker locker(&pauseMutex);
+    pauseRequested.fetchAndStoreOrdered(0);
+    pauseChanged.wakeAll();
+}
+
+bool CaptureThread::waitWhilePaused() {
+    if (!pauseRequested.fetchAndAddAcquire(0))
+        return true;
+
+    QMutexLocker locker(&pauseMutex);
+    parked = true;
+    pauseChanged.wakeAll();
+    while (pauseRequested.fetchAndAddAcquire(0) && !stopping.fetchAndAddAcquire(0))
+        pauseChanged.wait(&pauseMutex);
+    parked = false;
+    return !stopping.fetchAndAddAcquire(0);
+}
+
+int CaptureThread::overrunCount() const {
+    return backend->overrunCount();
+}
+
+void CaptureThread::run() {
+    int overruns = backend->overrunCount();
+    while (!stopping.fetchAndAddAcquire(0)) {
+        if (!waitWhilePaused())
+            break;
+        qint64 waitStarted = monotonicMicros();
+        int captured = backend->capture(samples, CAPTURE_POLL_TIMEOUT_US);
+        if (captured < 0)
+            break;
+        if (captured == 0)
+            continue;
+        qint64 now = monotonicMicros();
+        monitor->record(CaptureWaitStage, waitStarted, now);
+
+        int newOverruns = backend->overrunCount();
+        if (newOverruns != overruns) {
+            monitor->count(OverrunCounter, newOverruns - overruns);
+            overruns = newOverruns;
+        }
+
+        // The gate goes by the loudest channel, all channels are analysed together
+        float level = 0.0f;
+        for (int c = 0; c < backend->channelCount(); c++)
+            level = qMax(level, SilenceGate::level(samples[c], captured));
+
+        switch (gate->update(level, captured)) {
+        case GateOnset:
+            // Don't wait out the hop, and count the next one from here
+            scheduler->restart(samples[0]->written());
+            requestAnalysis(now);
+            break;
+        case GateOpen:
+            // Analyse once a hop worth of new samples has arrived, all channels are in step
+            if (scheduler->shouldAnalyse(samples[0]->written()))
+                requestAnalysis(now);
+            break;
+        case GateIdle:
+            requestAnalysis(now);
+            break;
+        case GateClosed:
+            requestAnalysis(now, true);
+            break;
+        case GateSilent:
+            break;
+        }
+    }
+}
+
+void CaptureThread::requestAnalysis(qint64 captured, bool gated) {
+    for (int i = 0; i < analysis.size(); i++)
+        analysis[i]->requestAnalysis(captured, gated);
+}
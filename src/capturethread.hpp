@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CaptureThread_HPP_
+#define CaptureThread_HPP_
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include "analysisscheduler.hpp"
+#include "analysisthread.hpp"
+#include "capturebackend.hpp"
+#include "latencymonitor.hpp"
+#include "ringbuffer.hpp"
+#include "silencegate.hpp"
+
+// How long a backend waits for a fragment before checking for a stop request
+#define CAPTURE_POLL_TIMEOUT_US 100000
+
+/*
+ * Drains the capture backend into the sample ring buffers, one per channel, and nothing
+ * else, so that a slow analysis never delays the next read. Once a hop has arrived it
+ * requests an analysis from every analysis thread, as long as the silence gate finds
+ * the loudest channel worth analysing. The thread ends by itself when the backend
+ * reaches the end of its stream.
+ *
+ * pause() parks the thread between two fragments and stops the backend, resume() starts
+ * both again. Everything downstream stays as it is, so the first readings after a resume
+ * come from a warm pipeline; they still see the end of what was captured before the
+ * pause, like after a gap between two notes.
+ */
+class CaptureThread : public QThread {
+    Q_OBJECT
+
+public:
+    CaptureThread(CaptureBackend* backend, RingBuffer<short>* const* samples,
+            AnalysisScheduler* scheduler, const QList<AnalysisThread*>& analysis,
+            SilenceGate* gate, LatencyMonitor* monitor, QObject* parent = 0);
+    virtual ~CaptureThread();
+
+    void stop();
+    // Both from the thread that owns the capture thread
+    void pause();
+    void resume();
+    int overrunCount() const;
+
+protected:
+    virtual void run();
+
+private:
+    void requestAnalysis(qint64 captured, bool gated = false);
+    // Waits while a pause is requested. Returns false if the thread is to stop.
+    bool waitWhilePaused();
+
+private:
+    CaptureBackend* backend;
+    RingBuffer<short>* const* samples;
+    AnalysisScheduler* scheduler;
+    QList<AnalysisThread*> analysis;
+    SilenceGate* gate;
+    LatencyMonitor* monitor;
+
+    QAtomicInt stopping;
+
+    QMutex pauseMutex;
+    QWaitCondition pauseChanged;
+    // Checked without the mutex for every fragment
+    QAtomicInt pauseRequested;
+    bool parked;
+};
+
+#endif /* CaptureThread_HPP_ */
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "capturetrace.hpp"
+
+#include <QMutexLocker>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Records start on 8 byte boundaries so that their timestamps are aligned
+static size_t padded(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+CaptureTraceWriter::CaptureTraceWriter() {
+    fd = -1;
+    mapping = NULL;
+    mappingSize = 0;
+    used = 0;
+    committed = 0;
+    channels = 1;
+    started = 0;
+    failed = false;
+}
+
+CaptureTraceWriter::~CaptureTraceWriter() {
+    close();
+}
+
+bool CaptureTraceWriter::open(const char* path, int sampleRate, int channels, size_t fragmentSize) {
+    close();
+    QMutexLocker locker(&mutex);
+
+    fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        qDebug("Cannot create trace %s\n", path);
+        return false;
+    }
+    failed = false;
+    used = 0;
+    committed = 0;
+    if (!grow(sizeof(CaptureTraceHeader))) {
+        qDebug("Cannot map trace %s\n", path);
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    CaptureTraceHeader* header = (CaptureTraceHeader*)mapping;
+    memcpy(header->magic, CAPTURE_TRACE_MAGIC, 4);
+    header->version = CAPTURE_TRACE_VERSION;
+    header->sampleRate = quint32(sampleRate);
+    header->channels = quint32(channels);
+    header->fragmentSize = quint32(fragmentSize);
+    header->reserved = 0;
+    header->length = 0;
+    used = sizeof(CaptureTraceHeader);
+    this->channels = channels;
+    started = monotonicMicros();
+    return true;
+}
+
+bool CaptureTraceWriter::close() {
+    QMutexLocker locker(&mutex);
+    if (fd < 0)
+        return true;
+
+    if (mapping != NULL)
+        munmap(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    // Drop the unused part of the last growth step
+    bool ok = ftruncate(fd, off_t(sizeof(CaptureTraceHeader) + committed)) == 0 && !failed;
+    ok = ::close(fd) == 0 && ok;
+    fd = -1;
+    return ok;
+}
+
+bool CaptureTraceWriter::grow(size_t needed) {
+    size_t size = mappingSize + CAPTURE_TRACE_GROWTH;
+    while (size < needed)
+        size += CAPTURE_TRACE_GROWTH;
+
+    // Not every target has mremap(), and the file holds everything written so far
+    if (mapping != NULL)
+        munmap(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    if (ftruncate(fd, off_t(size)) != 0)
+        return false;
+    void* m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED)
+        return false;
+    mapping = (char*)m;
+    mappingSize = size;
+    return true;
+}
+
+char* CaptureTraceWriter::append(CaptureTraceRecordType type, size_t size, qint64 time) {
+    if (mapping == NULL || failed)
+        return NULL;
+    size_t total = sizeof(CaptureTraceRecord) + padded(size);
+    if (used + total > mappingSize && !grow(used + total)) {
+        qDebug("Trace is full, recording stopped\n");
+        failed = true;
+        return NULL;
+    }
+
+    CaptureTraceRecord* record = (CaptureTraceRecord*)&mapping[used];
+    record->type = type;
+    record->size = quint32(size);
+    record->time = time - started;
+    char* payload = &mapping[used + sizeof(CaptureTraceRecord)];
+    used += total;
+    return payload;
+}
+
+void CaptureTraceWriter::commit() {
+    committed = used - sizeof(CaptureTraceHeader);
+    ((CaptureTraceHeader*)mapping)->length = committed;
+}
+
+void CaptureTraceWriter::recordFragment(const RingBuffer<short>* const* samples, size_t n, qint64 time) {
+    QMutexLocker locker(&mutex);
+    short* payload = (short*)append(FragmentTraceRecord, n*channels*sizeof(short), time);
+    if (payload == NULL)
+        return;
+    for (int c = 0; c < channels; c++)
+        samples[c]->copyLatest(&payload[c*n], n);
+    commit();
+}
+
+void CaptureTraceWriter::recordReading(const NoteInfo& note, qint64 time) {
+    QMutexLocker locker(&mutex);
+    CaptureTraceReading* reading = (CaptureTraceReading*)append(ReadingTraceRecord, sizeof(CaptureTraceReading), time);
+    if (reading == NULL)
+        return;
+    memcpy(reading->note, note.note, sizeof(reading->note));
+    reading->centsDiff = note.centsDiff;
+    reading->amplitude = note.amplitude;
+    reading->frequency = note.frequency;
+    reading->harmonic = note.harmonic;
+    reading->channel = note.channel;
+    reading->confidence = note.confidence;
+    reading->captured = note.timing.captured != 0 ? note.timing.captured - started : 0;
+    commit();
+}
+
+CaptureTraceReader::CaptureTraceReader() {
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    end = 0;
+    frameCount = 0;
+}
+
+CaptureTraceReader::~CaptureTraceReader() {
+    close();
+}
+
+bool CaptureTraceReader::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(CaptureTraceHeader)) {
+        ::close(fd);
+        return false;
+    }
+    mappingSize = size_t(st.st_size);
+    mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = NULL;
+        return false;
+    }
+
+    const CaptureTraceHeader* h = (const CaptureTraceHeader*)mapping;
+    if (memcmp(h->magic, CAPTURE_TRACE_MAGIC, 4) != 0 || h->version != CAPTURE_TRACE_VERSION ||
+            h->channels < 1 || h->sampleRate == 0) {
+        close();
+        return false;
+    }
+    header = h;
+    // A recording that was not closed still has its last growth step on the end
+    size_t length = mappingSize - sizeof(CaptureTraceHeader);
+    end = sizeof(CaptureTraceHeader) + (h->length < length ? size_t(h->length) : length);
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    CaptureTraceEntry entry;
+    size_t cursor = begin();
+    while (next(&cursor, &entry)) {
+        if (entry.type == FragmentTraceRecord)
+            frameCount += entry.frames;
+    }
+    return true;
+}
+
+void CaptureTraceReader::close() {
+    if (mapping != NULL)
+        munmap(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    end = 0;
+    frameCount = 0;
+}
+
+bool CaptureTraceReader::next(size_t* cursor, CaptureTraceEntry* entry) const {
+    const char* bytes = (const char*)mapping;
+    if (header == NULL || *cursor + sizeof(CaptureTraceRecord) > end)
+        return false;
+    const CaptureTraceRecord* record = (const CaptureTraceRecord*)&bytes[*cursor];
+    size_t payload = *cursor + sizeof(CaptureTraceRecord);
+    if (record->size > end - payload)
+        return false;
+    if (record->type == ReadingTraceRecord && record->size < sizeof(CaptureTraceReading))
+        return false;
+
+    entry->type = CaptureTraceRecordType(record->type);
+    entry->time = record->time;
+    entry->frames = record->type == FragmentTraceRecord ? record->size/(sizeof(short)*header->channels) : 0;
+    entry->samples = record->type == FragmentTraceRecord ? (const short*)&bytes[payload] : NULL;
+    entry->reading = record->type == ReadingTraceRecord ? (const CaptureTraceReading*)&bytes[payload] : NULL;
+    *cursor = payload + padded(record->size);
+    return true;
+}
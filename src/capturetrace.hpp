@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CaptureTrace_HPP_
+#define CaptureTrace_HPP_
+
+#include <QMutex>
+#include <QtGlobal>
+#include <stddef.h>
+#include "noteinfo.hpp"
+#include "ringbuffer.hpp"
+
+#define CAPTURE_TRACE_MAGIC "CTRC"
+#define CAPTURE_TRACE_VERSION 1
+// A recording grows its file by this much whenever the mapping is full
+#define CAPTURE_TRACE_GROWTH (4*1024*1024)
+
+// Traces start with this header, followed by records. Fields are in host byte order,
+// which is little endian on every supported target.
+struct CaptureTraceHeader {
+    char magic[4];
+    quint32 version;
+    quint32 sampleRate;
+    quint32 channels;
+    // Most samples per channel in a fragment
+    quint32 fragmentSize;
+    quint32 reserved;
+    // Bytes of complete records after the header. Only updated once a record has been
+    // written, so a recording that was cut short is readable up to its last record.
+    quint64 length;
+};
+
+enum CaptureTraceRecordType {
+    // Samples as the backend delivered them, all of the first channel, then all of the
+    // second and so on
+    FragmentTraceRecord = 1,
+    // A CaptureTraceReading
+    ReadingTraceRecord = 2
+};
+
+struct CaptureTraceRecord {
+    quint32 type;
+    // Bytes of payload following the record, which is padded to a multiple of 8
+    quint32 size;
+    // Microseconds since the recording started, when the fragment arrived or the
+    // reading was delivered
+    qint64 time;
+};
+
+struct CaptureTraceReading {
+    char note[16];
+    float centsDiff;
+    float amplitude;
+    float frequency;
+    qint32 harmonic;
+    qint32 channel;
+    float confidence;
+    // Arrival of the newest samples the reading was analysed from, on the time base of
+    // the records
+    qint64 captured;
+};
+
+// One record of a trace, as handed out by CaptureTraceReader
+struct CaptureTraceEntry {
+    CaptureTraceRecordType type;
+    qint64 time;
+    // Fragments only: samples per channel, and the channels one after another
+    size_t frames;
+    const short* samples;
+    // Readings only
+    const CaptureTraceReading* reading;
+};
+
+/*
+ * Appends the fragments a capture backend delivers, with their arrival times, and the
+ * readings made from them to an append-only, memory mapped trace file. Fragments are
+ * copied straight from the sample ring buffers into the mapping, so recording costs the
+ * capture thread one copy of each fragment and, every few megabytes, a remap.
+ * Fragments and readings come from different threads and are serialised by a mutex.
+ */
+class CaptureTraceWriter {
+public:
+    CaptureTraceWriter();
+    ~CaptureTraceWriter();
+
+    bool open(const char* path, int sampleRate, int channels, size_t fragmentSize);
+    // Cuts the file down to the records written. Returns false if anything could not
+    // be recorded.
+    bool close();
+    // Whether there is a file to close, which stays so after recording has failed
+    bool isOpen() const { return fd >= 0; }
+
+    // Records the newest n samples of each channel's ring buffer as one fragment that
+    // arrived at time, on the monotonicMicros() clock
+    void recordFragment(const RingBuffer<short>* const* samples, size_t n, qint64 time);
+    void recordReading(const NoteInfo& note, qint64 time);
+
+private:
+    CaptureTraceWriter(const CaptureTraceWriter&);
+    CaptureTraceWriter& operator=(const CaptureTraceWriter&);
+
+    // Returns the payload of a new record of size bytes, NULL if the file cannot grow.
+    // Called with the mutex held, the record counts once commit() is called.
+    char* append(CaptureTraceRecordType type, size_t size, qint64 time);
+    void commit();
+    bool grow(size_t needed);
+
+    QMutex mutex;
+    int fd;
+    char* mapping;
+    size_t mappingSize;
+    // Bytes in use, including the record being written
+    size_t used;
+    // Bytes of complete records after the header, as in CaptureTraceHeader::length. Kept
+    // here too, since a failed grow() leaves no mapping to read it from.
+    size_t committed;
+    int channels;
+    qint64 started;
+    bool failed;
+};
+
+/*
+ * Read-only memory mapping of a trace file. Records are looked at in place and handed
+ * out in the order they were written; a cursor is just a byte offset, so several can
+ * walk the same trace independently.
+ */
+class CaptureTraceReader {
+public:
+    CaptureTraceReader();
+    ~CaptureTraceReader();
+
+    // Returns false if the file cannot be mapped or is not a trace
+    bool open(const char* path);
+    void close();
+
+    int sampleRate() const { return header != NULL ? int(header->sampleRate) : 0; }
+    int channelCount() const { return header != NULL ? int(header->channels) : 0; }
+    size_t fragmentSize() const { return header != NULL ? header->fragmentSize : 0; }
+    // Seconds of audio in the fragments
+    double duration() const { return sampleRate() > 0 ? double(frameCount)/sampleRate() : 0; }
+
+    // Cursor at the first record
+    size_t begin() const { return sizeof(CaptureTraceHeader); }
+    // Reads the record at *cursor and moves the cursor past it. Returns false at the
+    // end of the trace.
+    bool next(size_t* cursor, CaptureTraceEntry* entry) const;
+
+private:
+    CaptureTraceReader(const CaptureTraceReader&);
+    CaptureTraceReader& operator=(const CaptureTraceReader&);
+
+    void* mapping;
+    size_t mappingSize;
+    const CaptureTraceHeader* header;
+    size_t end;
+    size_t frameCount;
+};
+
+#endif /* CaptureTrace_HPP_ */
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fftpeakdetector.hpp"
+
+FftPeakDetector::FftPeakDetector(int sampleRate, size_t fftSize, FftScalarType scalar)
+    : sampleRate(sampleRate), estimator(PEAK_DEFAULT_ESTIMATOR), fftSize(fftSize), maxSize(fftSize) {
+    size_t minSize = qMin(size_t(FFT_PEAK_MIN_SIZE), maxSize);
+    spectrum = createFftSpectrum(scalar, minSize, maxSize);
+    for (size_t size = minSize; size <= maxSize; size <<= 1)
+        harmonicsBySize.insert(size, new HarmonicAnalyser(sampleRate, size));
+    setFftSize(maxSize);
+}
+
+FftPeakDetector::~FftPeakDetector() {
+    qDeleteAll(harmonicsBySize);
+    delete spectrum;
+}
+
+void FftPeakDetector::setFftSize(size_t size) {
+    size_t rounded = harmonicsBySize.constBegin().key();
+    while (rounded < size && rounded < maxSize)
+        rounded <<= 1;
+
+    fftSize = rounded;
+    spectrum->setSize(rounded);
+    harmonics = harmonicsBySize.value(rounded);
+}
+
+bool FftPeakDetector::detect(const RingBuffer<short>* samples, PitchEstimate* estimate) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_REALTIME, &t0);
+
+    spectrum->transform(samples);
+
+    clock_gettime(CLOCK_REALTIME, &t1);
+    float fftSeconds = float(t1.tv_sec - t0.tv_sec) + float(t1.tv_nsec - t0.tv_nsec)/1000000000;
+
+    // Peaks with a maximum signal amplitude of 40 or less are too weak
+    SpectralPeak peak;
+    if (spectrum->findPeaks(1, fftSize/2, &peak, 1, 40*40) == 0)
+        return false;
+
+    size_t bin = peak.bin;
+    float adjustedFreq = float(bin)*sampleRate/fftSize;
+    int overtone = 1;
+
+    // Refined from the neighbouring bins where the peak has both
+    if (bin > 0 && bin < fftSize/2) {
+        kiss_fft_cpx bins[3];
+        spectrum->bins(bin - 1, 3, bins);
+        adjustedFreq = (float(bin) + peakOffset(estimator, FFT_SPECTRUM_WINDOW, bins))*sampleRate/fftSize;
+    }
+
+#ifdef DETECT_OVERTONES
+    // Detect if we caught an overtone instead of the fundamental
+    harmonics->setBudget(HARMONIC_BUDGET*fftSeconds);
+    overtone = harmonics->harmonicOf(spectrum->power(), adjustedFreq);
+#endif
+
+    estimate->frequency = adjustedFreq;
+    estimate->amplitude = sqrt(peak.power);
+    estimate->overtone = overtone;
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FftPeakDetector_HPP_
+#define FftPeakDetector_HPP_
+
+#include <QMap>
+#include <QtGlobal>
+#include <math.h>
+#include <time.h>
+#include "fftscalar.hpp"
+#include "fftspectrum.hpp"
+#include "harmonicanalyser.hpp"
+#include "peakestimator.hpp"
+#include "pitchdetector.hpp"
+#include "spectralpeaks.hpp"
+
+// Smallest FFT the size can be switched down to
+#define FFT_PEAK_MIN_SIZE 4096
+
+/*
+ * Picks the strongest bin of a windowed FFT and places the frequency between it and its
+ * neighbours with one of the PeakEstimators. Precision comes from the FFT size and the
+ * estimator, so low notes need long frames, the less so the better the estimator.
+ *
+ * The FFT size can be switched between FFT_PEAK_MIN_SIZE and the size the detector was
+ * created with. Plans, windows and harmonic analysers for every size in between are set
+ * up front, so switching is a lookup and never allocates.
+ *
+ * The spectrum is computed in float or in fixed point, see FftScalarType, which is
+ * chosen when the detector is created.
+ */
+class FftPeakDetector : public PitchDetector {
+public:
+    FftPeakDetector(int sampleRate, size_t fftSize, FftScalarType scalar = FFT_DEFAULT_SCALAR);
+    virtual ~FftPeakDetector();
+
+    virtual const char* name() const { return "fft"; }
+    virtual size_t frameSize() const { return fftSize; }
+    virtual bool detect(const RingBuffer<short>* samples, PitchEstimate* estimate);
+
+    // Rounded up to a power of two and limited to the supported sizes
+    void setFftSize(size_t size);
+    size_t maxFftSize() const { return maxSize; }
+    FftScalarType scalarType() const { return spectrum->scalarType(); }
+
+    void setEstimator(PeakEstimator estimator) { this->estimator = estimator; }
+    PeakEstimator peakEstimator() const { return estimator; }
+
+    // Power spectrum of the last detect(), bins 0 to half the FFT size it was made with
+    const float* power() const { return spectrum->power(); }
+
+private:
+    FftPeakDetector(const FftPeakDetector&);
+    FftPeakDetector& operator=(const FftPeakDetector&);
+
+private:
+    int sampleRate;
+    PeakEstimator estimator;
+
+    size_t fftSize;
+    size_t maxSize;
+    FftSpectrum* spectrum;
+    // Per FFT size
+    QMap<size_t, HarmonicAnalyser*> harmonicsBySize;
+    HarmonicAnalyser* harmonics;
+};
+
+#endif /* FftPeakDetector_HPP_ */
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fftplancache.hpp"
+
+#include <QMutexLocker>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "_kiss_fft_guts.h"
+
+// Large enough for AVX loads and stores
+#define BUFFER_ALIGNMENT 32
+
+Q_GLOBAL_STATIC(FftPlanCache, sharedPlanCache)
+
+void* allocAligned(size_t size) {
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, BUFFER_ALIGNMENT, size) != 0)
+        return NULL;
+    return ptr;
+}
+
+void freeAligned(void* ptr) {
+    free(ptr);
+}
+
+FftPlan::FftPlan(size_t nfft, bool inverse) : nfft(nfft), inverse(inverse) {
+    // A real FFT of size nfft is computed as a complex FFT of size nfft/2 followed by
+    // a split step, the same way kiss_fftr does it
+    size_t ncfft = nfft/2;
+    substate = kiss_fft_alloc(ncfft, inverse, 0, 0);
+    superTwiddles = new kiss_fft_cpx[ncfft/2];
+    for (size_t i = 0; i < ncfft/2; i++) {
+        double phase = -M_PI*((double)(i+1)/ncfft + 0.5);
+        if (inverse)
+            phase *= -1;
+        kf_cexp(&superTwiddles[i], phase);
+    }
+}
+
+FftPlan::~FftPlan() {
+    kiss_fft_free(substate);
+    delete[] superTwiddles;
+}
+
+void FftPlan::forward(const kiss_fft_scalar* timeData, kiss_fft_cpx* freqData, kiss_fft_cpx* scratch) const {
+    int ncfft = nfft/2;
+    kiss_fft_cpx fpnk, fpk, f1k, f2k, tw, tdc;
+
+    kiss_fft(substate, (const kiss_fft_cpx*)timeData, scratch);
+
+    tdc.r = scratch[0].r;
+    tdc.i = scratch[0].i;
+    C_FIXDIV(tdc, 2);
+    freqData[0].r = tdc.r + tdc.i;
+    freqData[ncfft].r = tdc.r - tdc.i;
+    freqData[ncfft].i = freqData[0].i = 0;
+
+    for (int k = 1; k <= ncfft/2; k++) {
+        fpk = scratch[k];
+        fpnk.r = scratch[ncfft-k].r;
+        fpnk.i = -scratch[ncfft-k].i;
+        C_FIXDIV(fpk, 2);
+        C_FIXDIV(fpnk, 2);
+
+        C_ADD(f1k, fpk, fpnk);
+        C_SUB(f2k, fpk, fpnk);
+        C_MUL(tw, f2k, superTwiddles[k-1]);
+
+        freqData[k].r = HALF_OF(f1k.r + tw.r);
+        freqData[k].i = HALF_OF(f1k.i + tw.i);
+        freqData[ncfft-k].r = HALF_OF(f1k.r - tw.r);
+        freqData[ncfft-k].i = HALF_OF(tw.i - f1k.i);
+    }
+}
+
+void FftPlan::backward(const kiss_fft_cpx* freqData, kiss_fft_scalar* timeData, kiss_fft_cpx* scratch) const {
+    int ncfft = nfft/2;
+
+    scratch[0].r = freqData[0].r + freqData[ncfft].r;
+    scratch[0].i = freqData[0].r - freqData[ncfft].r;
+    C_FIXDIV(scratch[0], 2);
+
+    for (int k = 1; k <= ncfft/2; k++) {
+        kiss_fft_cpx fk, fnkc, fek, fok, tmp;
+        fk = freqData[k];
+        fnkc.r = freqData[ncfft-k].r;
+        fnkc.i = -freqData[ncfft-k].i;
+        C_FIXDIV(fk, 2);
+        C_FIXDIV(fnkc, 2);
+
+        C_ADD(fek, fk, fnkc);
+        C_SUB(tmp, fk, fnkc);
+        C_MUL(fok, tmp, superTwiddles[k-1]);
+        C_ADD(scratch[k], fek, fok);
+        C_SUB(scratch[ncfft-k], fek, fok);
+        scratch[ncfft-k].i *= -1;
+    }
+
+    kiss_fft(substate, scratch, (kiss_fft_cpx*)timeData);
+}
+
+FftPlanCache::FftPlanCache() {
+}
+
+FftPlanCache::~FftPlanCache() {
+    qDeleteAll(plans);
+    qDeleteAll(q15Plans);
+    qDeleteAll(q31Plans);
+    for (QMap<quint64, kiss_fft_cfg>::const_iterator it = complexPlans.constBegin(); it != complexPlans.constEnd(); ++it)
+        kiss_fft_free(it.value());
+}
+
+FftPlanCache* FftPlanCache::shared() {
+    return sharedPlanCache();
+}
+
+const FftPlan* FftPlanCache::plan(size_t nfft, bool inverse) {
+    quint64 key = (quint64(nfft) << 1) | (inverse ? 1 : 0);
+
+    QMutexLocker locker(&mutex);
+    QMap<quint64, FftPlan*>::const_iterator it = plans.constFind(key);
+    if (it != plans.constEnd())
+        return it.value();
+
+    FftPlan* plan = new FftPlan(nfft, inverse);
+    plans.insert(key, plan);
+    return plan;
+}
+
+kiss_fft_cfg FftPlanCache::complexPlan(size_t nfft, bool inverse) {
+    quint64 key = (quint64(nfft) << 1) | (inverse ? 1 : 0);
+
+    QMutexLocker locker(&mutex);
+    QMap<quint64, kiss_fft_cfg>::const_iterator it = complexPlans.constFind(key);
+    if (it != complexPlans.constEnd())
+        return it.value();
+
+    kiss_fft_cfg plan = kiss_fft_alloc(nfft, inverse, 0, 0);
+    complexPlans.insert(key, plan);
+    return plan;
+}
+
+const FixedFftPlan<qint16>* FftPlanCache::q15Plan(size_t nfft) {
+    QMutexLocker locker(&mutex);
+    QMap<size_t, FixedFftPlan<qint16>*>::const_iterator it = q15Plans.constFind(nfft);
+    if (it != q15Plans.constEnd())
+        return it.value();
+
+    FixedFftPlan<qint16>* plan = new FixedFftPlan<qint16>(nfft);
+    q15Plans.insert(nfft, plan);
+    return plan;
+}
+
+const FixedFftPlan<qint32>* FftPlanCache::q31Plan(size_t nfft) {
+    QMutexLocker locker(&mutex);
+    QMap<size_t, FixedFftPlan<qint32>*>::const_iterator it = q31Plans.constFind(nfft);
+    if (it != q31Plans.constEnd())
+        return it.value();
+
+    FixedFftPlan<qint32>* plan = new FixedFftPlan<qint32>(nfft);
+    q31Plans.insert(nfft, plan);
+    return plan;
+}
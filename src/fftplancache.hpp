@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FftPlanCache_HPP_
+#define FftPlanCache_HPP_
+
+#include <QMap>
+#include <QMutex>
+#include <stddef.h>
+#include <string.h>
+#include "fixedfft.hpp"
+#include "kiss_fft.h"
+
+/*
+ * Real-input FFT plan for one size and direction. Unlike kiss_fftr_cfg, which carries
+ * its own scratch buffer, a plan only holds twiddle factors and is never written after
+ * construction, so one plan can be used from several threads at once as long as each
+ * of them passes its own FftWorkspace.
+ */
+class FftPlan {
+public:
+    FftPlan(size_t nfft, bool inverse);
+    ~FftPlan();
+
+    size_t size() const { return nfft; }
+    bool isInverse() const { return inverse; }
+
+    // nfft real samples in, nfft/2+1 bins out. Forward plans only.
+    void forward(const kiss_fft_scalar* timeData, kiss_fft_cpx* freqData, kiss_fft_cpx* scratch) const;
+    // nfft/2+1 bins in, nfft real samples out (unnormalised). Inverse plans only.
+    void backward(const kiss_fft_cpx* freqData, kiss_fft_scalar* timeData, kiss_fft_cpx* scratch) const;
+
+private:
+    FftPlan(const FftPlan&);
+    FftPlan& operator=(const FftPlan&);
+
+    size_t nfft;
+    bool inverse;
+    kiss_fft_cfg substate;
+    kiss_fft_cpx* superTwiddles;
+};
+
+void* allocAligned(size_t size);
+void freeAligned(void* ptr);
+
+/*
+ * Preallocated, aligned buffers for running plans up to a given size, for FFTs on real
+ * scalars of type T. Buffers only ever grow, so once a workspace has been reserved for
+ * the largest size in use the analysis path does not allocate. A workspace belongs to a
+ * single thread.
+ */
+template <typename T>
+class BasicFftWorkspace {
+public:
+    typedef typename FftComplex<T>::Type Complex;
+
+    BasicFftWorkspace() : nfft(0), timeBuff(NULL), freqBuff(NULL), scratchBuff(NULL) {}
+    ~BasicFftWorkspace() { release(); }
+
+    void reserve(size_t size) {
+        if (size <= nfft)
+            return;
+        release();
+        nfft = size;
+        timeBuff = (T*)allocAligned(sizeof(T)*nfft);
+        freqBuff = (Complex*)allocAligned(sizeof(Complex)*(nfft/2 + 1));
+        scratchBuff = (Complex*)allocAligned(sizeof(Complex)*(nfft/2));
+        memset(timeBuff, 0, sizeof(T)*nfft);
+        memset(freqBuff, 0, sizeof(Complex)*(nfft/2 + 1));
+    }
+    size_t capacity() const { return nfft; }
+
+    T* timeData() { return timeBuff; }
+    Complex* freqData() { return freqBuff; }
+    Complex* scratch() { return scratchBuff; }
+
+private:
+    BasicFftWorkspace(const BasicFftWorkspace&);
+    BasicFftWorkspace& operator=(const BasicFftWorkspace&);
+
+    void release() {
+        freeAligned(timeBuff);
+        freeAligned(freqBuff);
+        freeAligned(scratchBuff);
+    }
+
+    size_t nfft;
+    T* timeBuff;
+    Complex* freqBuff;
+    Complex* scratchBuff;
+};
+
+typedef BasicFftWorkspace<kiss_fft_scalar> FftWorkspace;
+
+/*
+ * Process-wide cache of FFT plans keyed by size and direction. Plans are created on
+ * first use and live until the cache is destroyed, so switching between sizes that
+ * have been used before costs a lookup only. Complex plans are plain kiss_fft configs,
+ * which kiss_fft only reads as long as input and output buffers differ. Fixed point
+ * plans are cached the same way.
+ */
+class FftPlanCache {
+public:
+    FftPlanCache();
+    ~FftPlanCache();
+
+    static FftPlanCache* shared();
+
+    const FftPlan* plan(size_t nfft, bool inverse = false);
+    kiss_fft_cfg complexPlan(size_t nfft, bool inverse = false);
+    const FixedFftPlan<qint16>* q15Plan(size_t nfft);
+    const FixedFftPlan<qint32>* q31Plan(size_t nfft);
+
+private:
+    FftPlanCache(const FftPlanCache&);
+    FftPlanCache& operator=(const FftPlanCache&);
+
+    QMutex mutex;
+    QMap<quint64, FftPlan*> plans;
+    QMap<quint64, kiss_fft_cfg> complexPlans;
+    QMap<size_t, FixedFftPlan<qint16>*> q15Plans;
+    QMap<size_t, FixedFftPlan<qint32>*> q31Plans;
+};
+
+#endif /* FftPlanCache_HPP_ */
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fftscalar.hpp"
+
+#include <string.h>
+
+const char* fftScalarName(FftScalarType type) {
+    const char* names[] = { "float", "q15", "q31" };
+    return names[type];
+}
+
+bool parseFftScalar(const char* name, FftScalarType* type) {
+    for (int i = 0; i < FftScalarTypeCount; i++) {
+        if (strcmp(name, fftScalarName(FftScalarType(i))) == 0) {
+            *type = FftScalarType(i);
+            return true;
+        }
+    }
+    return false;
+}
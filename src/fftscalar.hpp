@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FftScalar_HPP_
+#define FftScalar_HPP_
+
+#include <QtGlobal>
+#include <stddef.h>
+#include "fftplancache.hpp"
+#include "fixedfft.hpp"
+#include "kiss_fft.h"
+#include "windowing.hpp"
+
+enum FftScalarType {
+    FloatFftScalar,
+    // 16 bit fixed point, fastest on cores with weak floating point units but the
+    // least precise
+    Q15FftScalar,
+    // 32 bit fixed point
+    Q31FftScalar,
+    FftScalarTypeCount
+};
+
+// Arithmetic of the FFT peak detector unless another one is asked for. Set it for a
+// build with e.g. DEFINES += FFT_DEFAULT_SCALAR=Q15FftScalar.
+#ifndef FFT_DEFAULT_SCALAR
+#define FFT_DEFAULT_SCALAR FloatFftScalar
+#endif
+
+const char* fftScalarName(FftScalarType type);
+// Takes the names fftScalarName() gives, returns false for anything else
+bool parseFftScalar(const char* name, FftScalarType* type);
+
+/*
+ * What the stages of an FFT on real scalars of type T need to know about T: the plans,
+ * window tables and kernel to use, and the gain that brings the power of its bins to
+ * the units of the float FFT of the raw samples. Specialised for float, qint16 (Q15)
+ * and qint32 (Q31).
+ */
+template <typename T>
+struct FftScalar;
+
+template <>
+struct FftScalar<float> {
+    typedef kiss_fft_cpx Complex;
+    typedef FftPlan Plan;
+    typedef ::WindowKernel WindowKernel;
+
+    static FftScalarType type() { return FloatFftScalar; }
+    static const Plan* plan(size_t nfft) { return FftPlanCache::shared()->plan(nfft); }
+    static const float* window(WindowType type, size_t n) { return WindowCache::shared()->table(type, n); }
+    static WindowKernel windowKernel() { return ::windowKernel(); }
+    static float powerGain(size_t) { return 1.0f; }
+};
+
+template <>
+struct FftScalar<qint16> {
+    typedef FixedComplex<qint16> Complex;
+    typedef FixedFftPlan<qint16> Plan;
+    typedef void (*WindowKernel)(const short* in, const qint16* window, qint16* out, size_t n);
+
+    static FftScalarType type() { return Q15FftScalar; }
+    static const Plan* plan(size_t nfft) { return FftPlanCache::shared()->q15Plan(nfft); }
+    static const qint16* window(WindowType type, size_t n) { return WindowCache::shared()->q15Table(type, n); }
+    static WindowKernel windowKernel() { return windowSamplesQ15; }
+    // The samples go in as they are and the plan scales by 1/nfft
+    static float powerGain(size_t nfft) { return float(nfft)*float(nfft); }
+};
+
+template <>
+struct FftScalar<qint32> {
+    typedef FixedComplex<qint32> Complex;
+    typedef FixedFftPlan<qint32> Plan;
+    typedef void (*WindowKernel)(const short* in, const qint32* window, qint32* out, size_t n);
+
+    static FftScalarType type() { return Q31FftScalar; }
+    static const Plan* plan(size_t nfft) { return FftPlanCache::shared()->q31Plan(nfft); }
+    static const qint32* window(WindowType type, size_t n) { return WindowCache::shared()->q31Table(type, n); }
+    static WindowKernel windowKernel() { return windowSamplesQ31; }
+    // The samples go in shifted up by 16 bits and the plan scales by 1/nfft
+    static float powerGain(size_t nfft) { return (float(nfft)/65536)*(float(nfft)/65536); }
+};
+
+#endif /* FftScalar_HPP_ */
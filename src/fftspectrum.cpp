@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fftspectrum.hpp"
+
+#include <QMap>
+#include <math.h>
+
+namespace {
+
+template <typename T>
+class ScalarFftSpectrum : public FftSpectrum {
+public:
+    typedef FftScalar<T> Scalar;
+
+    ScalarFftSpectrum(size_t minSize, size_t maxSize) {
+        // Plans and windows are shared between spectra, the workspace is ours alone
+        // and sized for the largest FFT
+        for (size_t size = minSize; size <= maxSize; size <<= 1) {
+            SizeSetup setup;
+            setup.plan = Scalar::plan(size);
+            setup.window = Scalar::window(FFT_SPECTRUM_WINDOW, size);
+            setups.insert(size, setup);
+        }
+        workspace.reserve(maxSize);
+        windowSamples = Scalar::windowKernel();
+        picker = new SpectralPeakPicker(maxSize/2 + 1);
+        setSize(maxSize);
+    }
+
+    virtual ~ScalarFftSpectrum() {
+        delete picker;
+    }
+
+    virtual FftScalarType scalarType() const { return Scalar::type(); }
+
+    virtual void setSize(size_t size) {
+        const SizeSetup setup = setups.value(size);
+        nfft = size;
+        plan = setup.plan;
+        window = setup.window;
+        gain = Scalar::powerGain(size);
+    }
+
+    virtual size_t size() const { return nfft; }
+
+    virtual void transform(const RingBuffer<short>* samples) {
+        T* timeData = workspace.timeData();
+        RingBuffer<short>::Span first, second;
+        samples->latest(nfft, &first, &second);
+        windowSamples(first.data, window, timeData, first.size);
+        windowSamples(second.data, &window[first.size], &timeData[first.size], second.size);
+        plan->forward(timeData, workspace.freqData(), workspace.scratch());
+    }
+
+    virtual size_t findPeaks(size_t firstBin, size_t lastBin, SpectralPeak* peaks,
+            size_t maxPeaks, float minPower) {
+        return picker->find(workspace.freqData(), firstBin, lastBin, peaks, maxPeaks, minPower, gain);
+    }
+
+    virtual const float* power() const { return picker->power(); }
+
+    virtual void bins(size_t first, size_t n, kiss_fft_cpx* out) {
+        const typename Scalar::Complex* freqData = workspace.freqData();
+        float scale = sqrtf(gain);
+        for (size_t k = 0; k < n; k++) {
+            out[k].r = float(freqData[first + k].r)*scale;
+            out[k].i = float(freqData[first + k].i)*scale;
+        }
+    }
+
+private:
+    ScalarFftSpectrum(const ScalarFftSpectrum&);
+    ScalarFftSpectrum& operator=(const ScalarFftSpectrum&);
+
+    struct SizeSetup {
+        const typename Scalar::Plan* plan;
+        const T* window;
+    };
+
+    QMap<size_t, SizeSetup> setups;
+    BasicFftWorkspace<T> workspace;
+    typename Scalar::WindowKernel windowSamples;
+    SpectralPeakPicker* picker;
+
+    size_t nfft;
+    const typename Scalar::Plan* plan;
+    const T* window;
+    float gain;
+};
+
+}
+
+FftSpectrum* createFftSpectrum(FftScalarType type, size_t minSize, size_t maxSize) {
+    switch (type) {
+    case Q15FftScalar:
+        return new ScalarFftSpectrum<qint16>(minSize, maxSize);
+    case Q31FftScalar:
+        return new ScalarFftSpectrum<qint32>(minSize, maxSize);
+    case FloatFftScalar:
+    default:
+        return new ScalarFftSpectrum<float>(minSize, maxSize);
+    }
+}
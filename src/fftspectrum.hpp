@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FftSpectrum_HPP_
+#define FftSpectrum_HPP_
+
+#include <stddef.h>
+#include "fftscalar.hpp"
+#include "ringbuffer.hpp"
+#include "spectralpeaks.hpp"
+#include "windowing.hpp"
+
+// Window applied to the samples before the transform
+#define FFT_SPECTRUM_WINDOW HannWindow
+
+/*
+ * Windowed FFT of the newest samples of a ring buffer and the peaks of its power
+ * spectrum, computed in one of the FftScalarTypes. Whatever the scalar type, peaks and
+ * power come out in the units of the float FFT of the raw samples, so thresholds and
+ * the harmonic analysis work the same on all of them.
+ *
+ * Plans and windows for every power of two between the smallest and the largest size
+ * are set up on creation, so switching sizes never allocates. A spectrum belongs to a
+ * single thread.
+ */
+class FftSpectrum {
+public:
+    virtual ~FftSpectrum() {}
+
+    virtual FftScalarType scalarType() const = 0;
+
+    // One of the sizes the spectrum was created for
+    virtual void setSize(size_t nfft) = 0;
+    virtual size_t size() const = 0;
+
+    // Windows and transforms the newest size() samples, which may wrap around the ring
+    virtual void transform(const RingBuffer<short>* samples) = 0;
+    // Peaks of the last transform, see SpectralPeakPicker::find()
+    virtual size_t findPeaks(size_t firstBin, size_t lastBin, SpectralPeak* peaks,
+            size_t maxPeaks, float minPower) = 0;
+    // Power of the bins the last findPeaks() looked at
+    virtual const float* power() const = 0;
+    // Copies n bins of the last transform from first on, in the units of the float FFT
+    virtual void bins(size_t first, size_t n, kiss_fft_cpx* out) = 0;
+};
+
+// Sizes from minSize to maxSize, both powers of two
+FftSpectrum* createFftSpectrum(FftScalarType type, size_t minSize, size_t maxSize);
+
+#endif /* FftSpectrum_HPP_ */
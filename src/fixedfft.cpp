@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fixedfft.hpp"
+
+#include <math.h>
+
+namespace {
+
+// Arithmetic of a fixed point format: products and sums are formed in Wide and
+// rounded back to Bits fractional bits
+template <typename T> struct FixedMath;
+
+template <>
+struct FixedMath<qint16> {
+    typedef qint32 Wide;
+    enum { Bits = 15 };
+};
+
+template <>
+struct FixedMath<qint32> {
+    typedef qint64 Wide;
+    enum { Bits = 31 };
+};
+
+template <typename T>
+inline T toFixed(double x) {
+    typedef typename FixedMath<T>::Wide Wide;
+    return T(floor(x*double((Wide(1) << FixedMath<T>::Bits) - 1) + 0.5));
+}
+
+// Rounds a product of two fixed point values back to Bits fractional bits
+template <typename T>
+inline typename FixedMath<T>::Wide rescale(typename FixedMath<T>::Wide product) {
+    typedef typename FixedMath<T>::Wide Wide;
+    return (product + (Wide(1) << (FixedMath<T>::Bits - 1))) >> FixedMath<T>::Bits;
+}
+
+template <typename T>
+inline T halve(typename FixedMath<T>::Wide x) {
+    return T((x + 1) >> 1);
+}
+
+template <typename T>
+inline void setExp(FixedComplex<T>* c, double phase) {
+    c->r = toFixed<T>(cos(phase));
+    c->i = toFixed<T>(sin(phase));
+}
+
+}
+
+template <typename T>
+FixedFftPlan<T>::FixedFftPlan(size_t nfft) : nfft(nfft) {
+    size_t ncfft = nfft/2;
+    twiddles = new Complex[ncfft/2];
+    for (size_t k = 0; k < ncfft/2; k++)
+        setExp(&twiddles[k], -2*M_PI*k/ncfft);
+    // Same split step twiddles as FftPlan
+    superTwiddles = new Complex[ncfft/2];
+    for (size_t k = 0; k < ncfft/2; k++)
+        setExp(&superTwiddles[k], -M_PI*((double)(k+1)/ncfft + 0.5));
+}
+
+template <typename T>
+FixedFftPlan<T>::~FixedFftPlan() {
+    delete[] twiddles;
+    delete[] superTwiddles;
+}
+
+template <typename T>
+void FixedFftPlan<T>::transform(const Complex* in, Complex* out) const {
+    typedef typename FixedMath<T>::Wide Wide;
+    size_t n = nfft/2;
+
+    // Bit-reversed copy, the stages then work in place
+    size_t j = 0;
+    for (size_t i = 0; i < n; i++) {
+        out[j] = in[i];
+        size_t bit = n >> 1;
+        while (j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+
+    for (size_t half = 1; half < n; half <<= 1) {
+        size_t step = n/(2*half);
+        for (size_t start = 0; start < n; start += 2*half) {
+            Complex* a = &out[start];
+            Complex* b = &out[start + half];
+            for (size_t k = 0; k < half; k++) {
+                const Complex& w = twiddles[k*step];
+                Wide tr = rescale<T>(Wide(b[k].r)*w.r - Wide(b[k].i)*w.i);
+                Wide ti = rescale<T>(Wide(b[k].r)*w.i + Wide(b[k].i)*w.r);
+                Wide ar = a[k].r;
+                Wide ai = a[k].i;
+                a[k].r = halve<T>(ar + tr);
+                a[k].i = halve<T>(ai + ti);
+                b[k].r = halve<T>(ar - tr);
+                b[k].i = halve<T>(ai - ti);
+            }
+        }
+    }
+}
+
+template <typename T>
+void FixedFftPlan<T>::forward(const T* timeData, Complex* freqData, Complex* scratch) const {
+    typedef typename FixedMath<T>::Wide Wide;
+    size_t ncfft = nfft/2;
+
+    transform((const Complex*)timeData, scratch);
+
+    Wide dcr = halve<T>(scratch[0].r);
+    Wide dci = halve<T>(scratch[0].i);
+    freqData[0].r = T(dcr + dci);
+    freqData[ncfft].r = T(dcr - dci);
+    freqData[ncfft].i = freqData[0].i = 0;
+
+    for (size_t k = 1; k <= ncfft/2; k++) {
+        Wide fpkr = halve<T>(scratch[k].r);
+        Wide fpki = halve<T>(scratch[k].i);
+        Wide fpnkr = halve<T>(scratch[ncfft-k].r);
+        Wide fpnki = -Wide(halve<T>(scratch[ncfft-k].i));
+
+        Wide f1kr = fpkr + fpnkr;
+        Wide f1ki = fpki + fpnki;
+        Wide f2kr = fpkr - fpnkr;
+        Wide f2ki = fpki - fpnki;
+        const Complex& w = superTwiddles[k-1];
+        Wide twr = rescale<T>(f2kr*w.r - f2ki*w.i);
+        Wide twi = rescale<T>(f2kr*w.i + f2ki*w.r);
+
+        freqData[k].r = halve<T>(f1kr + twr);
+        freqData[k].i = halve<T>(f1ki + twi);
+        freqData[ncfft-k].r = halve<T>(f1kr - twr);
+        freqData[ncfft-k].i = halve<T>(twi - f1ki);
+    }
+}
+
+template class FixedFftPlan<qint16>;
+template class FixedFftPlan<qint32>;
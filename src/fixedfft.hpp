@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FixedFft_HPP_
+#define FixedFft_HPP_
+
+#include <QtGlobal>
+#include <stddef.h>
+#include "kiss_fft.h"
+
+// Complex value of a fixed point FFT, laid out like kiss_fft_cpx
+template <typename T>
+struct FixedComplex {
+    T r;
+    T i;
+};
+
+// Complex type of an FFT on real scalars of type T
+template <typename T>
+struct FftComplex {
+    typedef FixedComplex<T> Type;
+};
+
+template <>
+struct FftComplex<float> {
+    typedef kiss_fft_cpx Type;
+};
+
+/*
+ * Real-input FFT plan in fixed point, instantiated for Q15 (qint16) and Q31 (qint32)
+ * samples. It works like FftPlan, a complex FFT of half the size followed by a split
+ * step, but the complex FFT is a plain radix-2 one of our own: kissfft only does fixed
+ * point when it is built that way, for the whole program. Every stage halves its
+ * output, as kissfft's FIXED_POINT build does, so the spectrum comes out scaled by
+ * 1/nfft and cannot overflow unless the input is close to full scale in both the real
+ * and the imaginary part. A plan is never written after construction and can be used
+ * from several threads at once.
+ */
+template <typename T>
+class FixedFftPlan {
+public:
+    typedef FixedComplex<T> Complex;
+
+    explicit FixedFftPlan(size_t nfft);
+    ~FixedFftPlan();
+
+    size_t size() const { return nfft; }
+
+    // nfft real samples in, nfft/2+1 bins out, scaled by 1/nfft. scratch holds nfft/2
+    // bins.
+    void forward(const T* timeData, Complex* freqData, Complex* scratch) const;
+
+private:
+    FixedFftPlan(const FixedFftPlan&);
+    FixedFftPlan& operator=(const FixedFftPlan&);
+
+    void transform(const Complex* in, Complex* out) const;
+
+    size_t nfft;
+    // exp(-2*pi*i*k/(nfft/2)) for the first half of the complex FFT's bins
+    Complex* twiddles;
+    Complex* superTwiddles;
+};
+
+#endif /* FixedFft_HPP_ */
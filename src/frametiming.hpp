@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FrameTiming_HPP_
+#define FrameTiming_HPP_
+
+#include <QtGlobal>
+#include <time.h>
+
+// Monotonic clock in microseconds, the time base of all pipeline timestamps
+inline qint64 monotonicMicros() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return qint64(t.tv_sec)*1000000 + t.tv_nsec/1000;
+}
+
+/*
+ * Timestamps of one analysis frame on its way from the capture backend to the screen,
+ * in monotonicMicros(). A timestamp of 0 means the frame never passed that point, e.g.
+ * a reading from the batch analyser which has no capture thread.
+ */
+struct FrameTiming {
+    // The backend returned the newest samples of the frame
+    qint64 captured;
+    qint64 analysisStarted;
+    // The reading was posted for the UI
+    qint64 analysisFinished;
+};
+
+#endif /* FrameTiming_HPP_ */
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "harmonicanalyser.hpp"
+
+#include <QtGlobal>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "fftplancache.hpp"
+#include "spectralpeaks.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// out[j] = max(in[j*factor .. j*factor + factor - 1])
+static void maxPool(const float* in, float* out, size_t n, size_t factor) {
+    if (factor == 1) {
+        memcpy(out, in, sizeof(float)*n);
+        return;
+    }
+    for (size_t j = 0; j < n; j++) {
+        const float* group = &in[j*factor];
+        size_t i = 0;
+        float m = group[0];
+#if defined(__SSE2__)
+        if (factor >= 4) {
+            __m128 v = _mm_loadu_ps(group);
+            for (i = 4; i + 4 <= factor; i += 4)
+                v = _mm_max_ps(v, _mm_loadu_ps(&group[i]));
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            m = _mm_cvtss_f32(v);
+        }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+        if (factor >= 4) {
+            float32x4_t v = vld1q_f32(group);
+            for (i = 4; i + 4 <= factor; i += 4)
+                v = vmaxq_f32(v, vld1q_f32(&group[i]));
+            float32x2_t h = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+            m = vget_lane_f32(vpmax_f32(h, h), 0);
+        }
+#endif
+        for (; i < factor; i++)
+            if (group[i] > m)
+                m = group[i];
+        out[j] = m;
+    }
+}
+
+HarmonicAnalyser::HarmonicAnalyser(int sampleRate, size_t fftSize) : sampleRate(sampleRate), fftSize(fftSize) {
+    budget = 0;
+    meanCost = 0;
+    overBudgetCalls = 0;
+    underBudgetCalls = 0;
+
+    // Bins up to HARMONIC_MAX_FREQ, reduced to at most HARMONIC_MAX_BINS
+    size_t bins = size_t(HARMONIC_MAX_FREQ*fftSize/sampleRate);
+    if (bins > fftSize/2)
+        bins = fftSize/2;
+    size_t factor = 1;
+    while (bins/factor > HARMONIC_MAX_BINS)
+        factor *= 2;
+    maxBins = bins/factor;
+    minReduction = factor;
+
+    reduced = (float*)allocAligned(sizeof(float)*maxBins);
+    setReduction(factor);
+}
+
+HarmonicAnalyser::~HarmonicAnalyser() {
+    freeAligned(reduced);
+}
+
+void HarmonicAnalyser::setBudget(float seconds) {
+    budget = budget == 0 ? seconds : budget + HARMONIC_TIME_SMOOTHING*(seconds - budget);
+}
+
+void HarmonicAnalyser::setReduction(size_t factor) {
+    size_t bins = size_t(HARMONIC_MAX_FREQ*fftSize/sampleRate);
+    if (bins > fftSize/2)
+        bins = fftSize/2;
+    reduction = factor;
+    reducedBins = bins/factor;
+}
+
+void HarmonicAnalyser::reduce(const float* power) {
+    maxPool(power, reduced, reducedBins, reduction);
+    for (size_t j = 0; j < reducedBins; j++)
+        reduced[j] = log(reduced[j] + 1e-12f);
+}
+
+int HarmonicAnalyser::harmonicOf(const float* power, float peakFreq) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    reduce(power);
+
+    // Product spectrum, as a sum of logs, of the subharmonics of the peak. Harmonic
+    // positions are taken from the fractional candidate frequency and matched against
+    // the two bins around them, so rounding does not push the upper partials off their
+    // peaks.
+    float binWidth = float(reduction)*sampleRate/fftSize;
+    float bestScore = -1e30f;
+    int harmonic = 1;
+    for (int n = 1; n <= HARMONIC_COUNT; n++) {
+        float candidate = peakFreq/n;
+        if (candidate < HARMONIC_MIN_FREQ)
+            break;
+        float s = 0;
+        bool complete = true;
+        for (int h = 1; h <= HARMONIC_COUNT; h++) {
+            size_t b = size_t(h*candidate/binWidth);
+            if (b + 1 >= reducedBins) {
+                complete = false;
+                break;
+            }
+            s += qMax(reduced[b], reduced[b+1]);
+        }
+        // Only candidates with all their partials in range are compared, and the peak
+        // itself has to be one of them
+        if (!complete) {
+            if (n == 1)
+                break;
+            continue;
+        }
+        // A lower fundamental has to explain the spectrum clearly better than the peak
+        // itself, otherwise noise around a pure tone would pick one at random
+        if (n == 1)
+            bestScore = s + log(HARMONIC_MIN_GAIN);
+        else if (s > bestScore) {
+            bestScore = s;
+            harmonic = n;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    float seconds = float(t1.tv_sec - t0.tv_sec) + float(t1.tv_nsec - t0.tv_nsec)/1000000000;
+    meanCost = meanCost == 0 ? seconds : meanCost + HARMONIC_TIME_SMOOTHING*(seconds - meanCost);
+    if (budget <= 0)
+        return harmonic;
+
+    // Halve the resolution of the reduced spectrum while the cost stays over budget,
+    // double it again while it stays well under. The counts start afresh after each
+    // step, which leaves the mean cost time to follow.
+    overBudgetCalls = meanCost > budget ? overBudgetCalls + 1 : 0;
+    underBudgetCalls = meanCost < HARMONIC_RESTORE_SHARE*budget ? underBudgetCalls + 1 : 0;
+    if (overBudgetCalls >= HARMONIC_BUDGET_CALLS && reducedBins/2 >= HARMONIC_MIN_BINS) {
+        setReduction(reduction*2);
+        overBudgetCalls = 0;
+    } else if (underBudgetCalls >= HARMONIC_BUDGET_CALLS && reduction > minReduction) {
+        setReduction(reduction/2);
+        underBudgetCalls = 0;
+    }
+
+    return harmonic;
+}
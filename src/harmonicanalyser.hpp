@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HarmonicAnalyser_HPP_
+#define HarmonicAnalyser_HPP_
+
+#include <stddef.h>
+
+// Harmonics multiplied together in the harmonic product spectrum
+#define HARMONIC_COUNT 4
+#define HARMONIC_MIN_FREQ 25.0f
+// Power ratio by which a lower fundamental has to beat the peak itself
+#define HARMONIC_MIN_GAIN 10000.0f
+// Partials above this are not looked at
+#define HARMONIC_MAX_FREQ 8000.0f
+// Upper limit for the reduced spectrum, the budget may shrink it further
+#define HARMONIC_MAX_BINS 4096
+#define HARMONIC_MIN_BINS 256
+// Share of the spectrum computation time the harmonic analysis may add
+#define HARMONIC_BUDGET 0.1f
+// Smoothing factor for the measured cost and the budget
+#define HARMONIC_TIME_SMOOTHING 0.2f
+// Calls in a row over budget, or well under it, before the resolution changes
+#define HARMONIC_BUDGET_CALLS 10
+// Share of the budget the cost has to stay under before the resolution is doubled again
+#define HARMONIC_RESTORE_SHARE 0.4f
+
+/*
+ * Corrects octave errors with a harmonic product spectrum. The power spectrum of the FFT,
+ * as left behind by SpectralPeakPicker, is reduced to a coarse log power spectrum by
+ * keeping the strongest bin of each group. Each subharmonic of the strongest peak is
+ * then scored by the sum of log powers at 1..HARMONIC_COUNT times its frequency, and
+ * the candidate whose partials explain the spectrum best tells which harmonic the peak
+ * is.
+ *
+ * The cost of each call is measured. If it stays over its budget the spectrum is reduced
+ * further, trading resolution of the candidate fundamentals for time, and once it stays
+ * well under the budget the resolution is restored step by step. Both the cost and the
+ * budget are smoothed, so a single preempted call changes nothing.
+ */
+class HarmonicAnalyser {
+public:
+    HarmonicAnalyser(int sampleRate, size_t fftSize);
+    ~HarmonicAnalyser();
+
+    // Returns which harmonic of the fundamental the peak at peakFreq is, 1 if it is
+    // the fundamental itself. power needs to hold the bins from HARMONIC_MIN_FREQ up
+    // to HARMONIC_MAX_FREQ.
+    int harmonicOf(const float* power, float peakFreq);
+
+    // Time the analysis may take, e.g. a share of the FFT time. Smoothed over calls,
+    // so a single timing can be passed each time.
+    void setBudget(float seconds);
+    float cost() const { return meanCost; }
+    size_t reducedSize() const { return reducedBins; }
+
+private:
+    HarmonicAnalyser(const HarmonicAnalyser&);
+    HarmonicAnalyser& operator=(const HarmonicAnalyser&);
+
+    void setReduction(size_t factor);
+    void reduce(const float* power);
+
+    int sampleRate;
+    size_t fftSize;
+    size_t reduction;
+    // Reduction for HARMONIC_MAX_BINS, the finest the budget can restore
+    size_t minReduction;
+    size_t reducedBins;
+    size_t maxBins;
+    float* reduced;
+
+    float budget;
+    float meanCost;
+    int overBudgetCalls;
+    int underBudgetCalls;
+};
+
+#endif /* HarmonicAnalyser_HPP_ */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "latencyhistogram.hpp"
+
+LatencyHistogram::LatencyHistogram() {
+}
+
+int LatencyHistogram::bucketOf(int micros) {
+    if (micros < 2*LATENCY_SUB_BUCKETS)
+        return micros;
+    int shift = 1;
+    while ((micros >> shift) >= 2*LATENCY_SUB_BUCKETS)
+        shift++;
+    return shift*LATENCY_SUB_BUCKETS + (micros >> shift);
+}
+
+int LatencyHistogram::bucketStart(int bucket) {
+    if (bucket < 2*LATENCY_SUB_BUCKETS)
+        return bucket;
+    int shift = bucket/LATENCY_SUB_BUCKETS - 1;
+    return (bucket - shift*LATENCY_SUB_BUCKETS) << shift;
+}
+
+void LatencyHistogram::record(int micros) {
+    if (micros < 0)
+        micros = 0;
+    counts[bucketOf(micros)].fetchAndAddRelaxed(1);
+
+    int seen = maximum.fetchAndAddRelaxed(0);
+    while (micros > seen && !maximum.testAndSetRelaxed(seen, micros))
+        seen = maximum.fetchAndAddRelaxed(0);
+}
+
+LatencySummary LatencyHistogram::summarise(bool clear) {
+    LatencySummary summary;
+    int snapshot[LATENCY_BUCKETS];
+    summary.count = 0;
+    summary.max = clear ? maximum.fetchAndStoreRelaxed(0) : maximum.fetchAndAddRelaxed(0);
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        snapshot[b] = clear ? counts[b].fetchAndStoreRelaxed(0) : counts[b].fetchAndAddRelaxed(0);
+        summary.count += snapshot[b];
+    }
+
+    summary.mean = summary.p50 = summary.p90 = summary.p99 = 0;
+    if (summary.count == 0)
+        return summary;
+
+    // Walk up the buckets once, taking each percentile where its rank is reached
+    const int p50Rank = (summary.count + 1)/2;
+    const int p90Rank = (summary.count*9 + 9)/10;
+    const int p99Rank = (summary.count*99 + 99)/100;
+    double total = 0;
+    int seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (snapshot[b] == 0)
+            continue;
+        int end = b + 1 < LATENCY_BUCKETS ? bucketStart(b + 1) : summary.max + 1;
+        int mid = (bucketStart(b) + end - 1)/2;
+        total += double(mid)*snapshot[b];
+        if (seen < p50Rank && seen + snapshot[b] >= p50Rank)
+            summary.p50 = mid;
+        if (seen < p90Rank && seen + snapshot[b] >= p90Rank)
+            summary.p90 = mid;
+        if (seen < p99Rank && seen + snapshot[b] >= p99Rank)
+            summary.p99 = mid;
+        seen += snapshot[b];
+    }
+    // A midpoint can lie above the largest value in the top bucket
+    summary.mean = qMin(int(total/summary.count), summary.max);
+    summary.p50 = qMin(summary.p50, summary.max);
+    summary.p90 = qMin(summary.p90, summary.max);
+    summary.p99 = qMin(summary.p99, summary.max);
+    return summary;
+}
+
+void LatencyHistogram::clear() {
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+        counts[b].fetchAndStoreRelaxed(0);
+    maximum.fetchAndStoreRelaxed(0);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LatencyHistogram_HPP_
+#define LatencyHistogram_HPP_
+
+#include <QAtomicInt>
+#include <QtGlobal>
+
+// Each power of two range is split into this many buckets, which bounds the relative
+// error of a recorded value to 1/16
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+// Enough buckets for any non-negative int
+#define LATENCY_BUCKETS ((32 - LATENCY_SUB_BUCKET_BITS)*LATENCY_SUB_BUCKETS)
+
+// Latency statistics in microseconds. Apart from count and max the values are
+// bucket midpoints, so they are accurate to the bucket resolution.
+struct LatencySummary {
+    int count;
+    int mean;
+    int p50;
+    int p90;
+    int p99;
+    int max;
+};
+
+/*
+ * HDR-style histogram of latencies in microseconds: values below LATENCY_SUB_BUCKETS
+ * are counted exactly, larger ones in log-linear buckets. Recording is a couple of
+ * relaxed atomic operations and never blocks, so it can be called from the capture and
+ * analysis threads while another thread summarises the histogram.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(int micros);
+    // Optionally clears the counts, so that the next summary covers only what was
+    // recorded since. Values recorded while summarising go into one of the two.
+    LatencySummary summarise(bool clear = false);
+    void clear();
+
+    static int bucketOf(int micros);
+    static int bucketStart(int bucket);
+
+private:
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    QAtomicInt counts[LATENCY_BUCKETS];
+    QAtomicInt maximum;
+};
+
+#endif /* LatencyHistogram_HPP_ */
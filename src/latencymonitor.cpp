@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "latencymonitor.hpp"
+
+#include <limits.h>
+#include <stdio.h>
+
+LatencyMonitor::LatencyMonitor() {
+}
+
+void LatencyMonitor::record(LatencyStage stage, qint64 from, qint64 to) {
+    if (from == 0)
+        return;
+    qint64 micros = to - from;
+    histograms[stage].record(micros > INT_MAX ? INT_MAX : int(micros));
+}
+
+void LatencyMonitor::count(PipelineCounter counter, int n) {
+    counters[counter].fetchAndAddRelaxed(n);
+}
+
+void LatencyMonitor::recordAnalysis(const FrameTiming& timing) {
+    record(BufferingStage, timing.captured, timing.analysisStarted);
+    record(AnalysisStage, timing.analysisStarted, timing.analysisFinished);
+}
+
+void LatencyMonitor::recordDisplayed(const FrameTiming& timing) {
+    qint64 now = monotonicMicros();
+    record(DeliveryStage, timing.analysisFinished, now);
+    record(EndToEndStage, timing.captured, now);
+    count(DisplayedReadingCounter);
+}
+
+LatencySummary LatencyMonitor::summary(LatencyStage stage, bool clear) {
+    return histograms[stage].summarise(clear);
+}
+
+int LatencyMonitor::counter(PipelineCounter counter) const {
+    return counters[counter].fetchAndAddRelaxed(0);
+}
+
+void LatencyMonitor::dump() {
+    for (int s = 0; s < LatencyStageCount; s++) {
+        LatencySummary latency = summary(LatencyStage(s), true);
+        if (latency.count == 0)
+            continue;
+        qDebug("%-12s n=%d mean=%.2f p50=%.2f p90=%.2f p99=%.2f max=%.2f ms",
+                stageName(LatencyStage(s)), latency.count, latency.mean/1000.0f,
+                latency.p50/1000.0f, latency.p90/1000.0f, latency.p99/1000.0f, latency.max/1000.0f);
+    }
+
+    char line[256];
+    int length = 0;
+    for (int c = 0; c < PipelineCounterCount && length < int(sizeof(line)); c++)
+        length += snprintf(&line[length], sizeof(line) - length, "%s%s=%d", c > 0 ? " " : "",
+                counterName(PipelineCounter(c)), counter(PipelineCounter(c)));
+    qDebug("%s", line);
+}
+
+const char* LatencyMonitor::stageName(LatencyStage stage) {
+    const char* names[] = { "capture-wait", "buffering", "analysis", "delivery", "end-to-end", "cold-start",
+            "resume" };
+    return names[stage];
+}
+
+const char* LatencyMonitor::counterName(PipelineCounter counter) {
+    const char* names[] = { "readings", "silent", "unstable", "gated", "displayed", "coalesced", "overruns",
+            "dropped-frames", "dropped-readings" };
+    return names[counter];
+}
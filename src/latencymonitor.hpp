@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LatencyMonitor_HPP_
+#define LatencyMonitor_HPP_
+
+#include <QAtomicInt>
+#include <QtGlobal>
+#include "frametiming.hpp"
+#include "latencyhistogram.hpp"
+
+enum LatencyStage {
+    // Time the capture thread spent waiting in the backend for a fragment
+    CaptureWaitStage,
+    // From the newest samples arriving to the analysis starting on them
+    BufferingStage,
+    AnalysisStage,
+    // From the reading being posted to the UI having shown it
+    DeliveryStage,
+    // From the newest samples arriving to the UI having shown the reading
+    EndToEndStage,
+    // From capture being started, or resumed after a pause, to the first reading of
+    // samples captured since
+    ColdStartStage,
+    ResumeStage,
+    LatencyStageCount
+};
+
+enum PipelineCounter {
+    ReadingCounter,
+    SilentReadingCounter,
+    // Readings that had a pitch but were rejected as unstable
+    UnstableReadingCounter,
+    // Blank readings for frames the silence gate kept from analysis
+    GatedReadingCounter,
+    DisplayedReadingCounter,
+    // Readings the UI replaced with a newer one before it got to show them
+    CoalescedReadingCounter,
+    OverrunCounter,
+    DroppedFrameCounter,
+    DroppedReadingCounter,
+    PipelineCounterCount
+};
+
+/*
+ * Collects per-stage latencies of the capture/analysis/UI pipeline into histograms,
+ * along with counters of what happened to the frames. Frames carry their timestamps
+ * in a FrameTiming, and each thread records the stages it can see the end of. All
+ * recording is lock-free and safe from any thread.
+ *
+ * The end-to-end latency starts when the backend hands over the newest samples, so it
+ * does not include the time those samples spent in the driver's fragment.
+ */
+class LatencyMonitor {
+public:
+    LatencyMonitor();
+
+    // Records the time between two timestamps, unless the first one is missing
+    void record(LatencyStage stage, qint64 from, qint64 to);
+    void count(PipelineCounter counter, int n = 1);
+
+    // Buffering and analysis time of a finished analysis
+    void recordAnalysis(const FrameTiming& timing);
+    // Delivery and end-to-end time of a reading the UI has just shown
+    void recordDisplayed(const FrameTiming& timing);
+
+    LatencySummary summary(LatencyStage stage, bool clear = false);
+    int counter(PipelineCounter counter) const;
+
+    // Logs the latencies since the previous dump and the counters since the start
+    void dump();
+
+    static const char* stageName(LatencyStage stage);
+    static const char* counterName(PipelineCounter counter);
+
+private:
+    LatencyMonitor(const LatencyMonitor&);
+    LatencyMonitor& operator=(const LatencyMonitor&);
+
+    LatencyHistogram histograms[LatencyStageCount];
+    mutable QAtomicInt counters[PipelineCounterCount];
+};
+
+#endif /* LatencyMonitor_HPP_ */
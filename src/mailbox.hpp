@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef Mailbox_HPP_
+#define Mailbox_HPP_
+
+#include <QMutex>
+#include <QMutexLocker>
+
+/*
+ * Latest-wins mailbox holding at most one value. Posting over an unread value replaces
+ * it, so a slow reader only ever sees the newest value instead of a growing backlog.
+ */
+template <typename T>
+class Mailbox {
+public:
+    Mailbox() : full(false), replaced(0) {}
+
+    // Returns true if the mailbox was empty, i.e. the reader needs to be notified.
+    bool post(const T& v) {
+        QMutexLocker locker(&mutex);
+        bool wasEmpty = !full;
+        if (full)
+            replaced++;
+        value = v;
+        full = true;
+        return wasEmpty;
+    }
+
+    // Returns false if there was nothing to take.
+    bool take(T* v) {
+        QMutexLocker locker(&mutex);
+        if (!full)
+            return false;
+        *v = value;
+        full = false;
+        return true;
+    }
+
+    // Number of values that were overwritten before being read.
+    int replacedCount() const {
+        QMutexLocker locker(&mutex);
+        return replaced;
+    }
+
+private:
+    mutable QMutex mutex;
+    T value;
+    bool full;
+    int replaced;
+};
+
+#endif /* Mailbox_HPP_ */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mappedaudiofile.hpp"
+
+#include <QtGlobal>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// WAV stores everything little endian
+static unsigned int readLittleEndian(const unsigned char* bytes, int n) {
+    unsigned int value = 0;
+    for (int i = n - 1; i >= 0; i--)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+MappedAudioFile::MappedAudioFile() {
+    mapping = NULL;
+    mappingSize = 0;
+    samples = NULL;
+    frameCount = 0;
+    rate = 0;
+    channels = 1;
+}
+
+MappedAudioFile::~MappedAudioFile() {
+    close();
+}
+
+bool MappedAudioFile::open(const char* path, int rawSampleRate, int rawChannels) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        qDebug("Cannot open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    mappingSize = size_t(st.st_size);
+    mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        qDebug("Cannot map %s\n", path);
+        mapping = NULL;
+        return false;
+    }
+    // Samples are read front to back exactly once
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    const unsigned char* bytes = (const unsigned char*)mapping;
+    if (mappingSize >= 12 && memcmp(bytes, "RIFF", 4) == 0) {
+        if (!parseWav(bytes, mappingSize)) {
+            qDebug("%s is not a 16 bit PCM WAV file\n", path);
+            close();
+            return false;
+        }
+    } else if (rawSampleRate > 0 && rawChannels > 0) {
+        rate = rawSampleRate;
+        channels = rawChannels;
+        samples = (const short*)bytes;
+        frameCount = mappingSize/(sizeof(short)*channels);
+    } else {
+        qDebug("%s has no WAV header and no raw sample rate was given\n", path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedAudioFile::parseWav(const unsigned char* bytes, size_t size) {
+    if (memcmp(&bytes[8], "WAVE", 4) != 0)
+        return false;
+
+    // Walk the chunks up to the data, fmt has to come first
+    bool haveFormat = false;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const unsigned char* chunk = &bytes[pos];
+        size_t chunkSize = readLittleEndian(&chunk[4], 4);
+        pos += 8;
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || pos + 16 > size)
+                return false;
+            int audioFormat = int(readLittleEndian(&bytes[pos], 2));
+            channels = int(readLittleEndian(&bytes[pos + 2], 2));
+            rate = int(readLittleEndian(&bytes[pos + 4], 4));
+            int bits = int(readLittleEndian(&bytes[pos + 14], 2));
+            // 0xFFFE is WAVE_FORMAT_EXTENSIBLE, which is plain PCM for 16 bit files
+            if ((audioFormat != 1 && audioFormat != 0xFFFE) || bits != 16 || channels < 1 || rate <= 0)
+                return false;
+            haveFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat || (pos & 1))
+                return false;
+            // Recorders that were interrupted leave the size unset or too big
+            if (chunkSize > size - pos)
+                chunkSize = size - pos;
+            samples = (const short*)&bytes[pos];
+            frameCount = chunkSize/(sizeof(short)*channels);
+            return true;
+        }
+        // Chunks are padded to an even size
+        pos += chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+void MappedAudioFile::close() {
+    if (mapping != NULL)
+        munmap(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    samples = NULL;
+    frameCount = 0;
+}
+
+void MappedAudioFile::mixDown(size_t firstFrame, size_t n, short* out) const {
+    const short* in = &samples[firstFrame*channels];
+    if (channels == 1) {
+        memcpy(out, in, n*sizeof(short));
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        int sum = 0;
+        for (int c = 0; c < channels; c++)
+            sum += in[i*channels + c];
+        out[i] = short(sum/channels);
+    }
+}
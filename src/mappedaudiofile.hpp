@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MappedAudioFile_HPP_
+#define MappedAudioFile_HPP_
+
+#include <stddef.h>
+
+/*
+ * Read-only memory mapping of a 16 bit PCM audio file, either WAV or headerless
+ * little endian samples. Nothing is read up front, pages come in as the samples are
+ * looked at, so arbitrarily long files can be streamed through the engine.
+ */
+class MappedAudioFile {
+public:
+    MappedAudioFile();
+    ~MappedAudioFile();
+
+    // Files without a RIFF header are taken as raw samples at rawSampleRate with
+    // rawChannels interleaved channels. Returns false if the file cannot be mapped or
+    // is neither.
+    bool open(const char* path, int rawSampleRate = 0, int rawChannels = 1);
+    void close();
+
+    int sampleRate() const { return rate; }
+    int channelCount() const { return channels; }
+    // Samples per channel
+    size_t frames() const { return frameCount; }
+    double duration() const { return rate > 0 ? double(frameCount)/rate : 0; }
+
+    // Interleaved samples, frames()*channelCount() of them
+    const short* data() const { return samples; }
+    // Averages n frames starting at firstFrame down to mono
+    void mixDown(size_t firstFrame, size_t n, short* out) const;
+
+private:
+    MappedAudioFile(const MappedAudioFile&);
+    MappedAudioFile& operator=(const MappedAudioFile&);
+
+    bool parseWav(const unsigned char* bytes, size_t size);
+
+    void* mapping;
+    size_t mappingSize;
+    const short* samples;
+    size_t frameCount;
+    int rate;
+    int channels;
+};
+
+#endif /* MappedAudioFile_HPP_ */
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NoteInfo_HPP_
+#define NoteInfo_HPP_
+
+#include "frametiming.hpp"
+
+struct NoteInfo {
+	char note[16];
+	float centsDiff;
+	float amplitude;
+	float frequency;
+	// Which harmonic of the note the measured frequency is, 1 for the fundamental
+	int harmonic;
+	// Capture channel the reading comes from, 0 for mono capture
+	int channel;
+	// How sure the analyser is of the pitch, from 0 to 1. A note is only given from 1
+	// on, but keeps being given down to just above 0 once it is.
+	float confidence;
+	FrameTiming timing;
+};
+
+#endif /* NoteInfo_HPP_ */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "peakestimator.hpp"
+
+#include <math.h>
+#include <string.h>
+
+const char* peakEstimatorName(PeakEstimator estimator) {
+    const char* names[] = { "parabolic", "gaussian", "quinn", "jain" };
+    return names[estimator];
+}
+
+bool parsePeakEstimator(const char* name, PeakEstimator* estimator) {
+    for (int i = 0; i < PeakEstimatorCount; i++) {
+        if (strcmp(name, peakEstimatorName(PeakEstimator(i))) == 0) {
+            *estimator = PeakEstimator(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static float magnitude(const kiss_fft_cpx& c) {
+    return sqrtf(c.r*c.r + c.i*c.i);
+}
+
+// Real part of a/b
+static float realRatio(const kiss_fft_cpx& a, const kiss_fft_cpx& b) {
+    float power = b.r*b.r + b.i*b.i;
+    return power > 0 ? (a.r*b.r + a.i*b.i)/power : 0;
+}
+
+static float parabolicOffset(float left, float peak, float right) {
+    float denominator = left - 2*peak + right;
+    if (denominator >= 0)
+        return 0;
+    return 0.5f*(left - right)/denominator;
+}
+
+// Quinn's correction term for the second estimator
+static float quinnTau(float x) {
+    const float root = 0.81649658f; // sqrt(2/3)
+    return 0.25f*logf(3*x*x + 6*x + 1) - 0.10206207f*logf((x + 1 - root)/(x + 1 + root));
+}
+
+static float quinnOffset(const kiss_fft_cpx* bins) {
+    float ap = realRatio(bins[2], bins[1]);
+    float am = realRatio(bins[0], bins[1]);
+    if (ap >= 1 || am >= 1)
+        return 0;
+    float dp = -ap/(1 - ap);
+    float dm = am/(1 - am);
+    return 0.5f*(dp + dm) + quinnTau(dp*dp) - quinnTau(dm*dm);
+}
+
+// The Hann window turns the bins X of a sinusoid that are proportional to 1/(d - k) into
+// 0.5X[k] - 0.25(X[k-1] + X[k+1]), proportional to 1/((d - k)((d - k)^2 - 1)). Their
+// ratios then give the offset d from either neighbour; the two are weighted by the
+// neighbour's power, the weaker one is the noisier.
+static float hannQuinnOffset(const kiss_fft_cpx* bins) {
+    float rp = realRatio(bins[2], bins[1]);
+    float rm = realRatio(bins[0], bins[1]);
+    if (rp >= 1 || rm >= 1)
+        return 0;
+    float dp = (2*rp + 1)/(rp - 1);
+    float dm = (2*rm + 1)/(1 - rm);
+    float wp = bins[2].r*bins[2].r + bins[2].i*bins[2].i;
+    float wm = bins[0].r*bins[0].r + bins[0].i*bins[0].i;
+    return wp + wm > 0 ? (dp*wp + dm*wm)/(wp + wm) : 0;
+}
+
+// Magnitudes only, with the ratio a of the stronger neighbour to the peak: a/(1 + a) for
+// the rectangular window, (2a - 1)/(1 + a) for the Hann window
+static float jainOffset(const kiss_fft_cpx* bins, bool hann) {
+    float peak = magnitude(bins[1]);
+    if (peak <= 0)
+        return 0;
+    float left = magnitude(bins[0]);
+    float right = magnitude(bins[2]);
+    float a = (right > left ? right : left)/peak;
+    float d = hann ? (2*a - 1)/(1 + a) : a/(1 + a);
+    return right > left ? d : -d;
+}
+
+float peakOffset(PeakEstimator estimator, WindowType window, const kiss_fft_cpx* bins) {
+    bool rectangular = window == RectangularWindow;
+    float offset;
+    switch (estimator) {
+    case ParabolicPeakEstimator:
+        offset = parabolicOffset(magnitude(bins[0]), magnitude(bins[1]), magnitude(bins[2]));
+        break;
+    case QuinnPeakEstimator:
+        if (rectangular || window == HannWindow) {
+            offset = rectangular ? quinnOffset(bins) : hannQuinnOffset(bins);
+            break;
+        }
+        // Fall through
+    case JainPeakEstimator:
+        if (rectangular || window == HannWindow) {
+            offset = jainOffset(bins, !rectangular);
+            break;
+        }
+        // Fall through
+    case GaussianPeakEstimator:
+    default: {
+        float tiny = 1e-20f;
+        offset = parabolicOffset(logf(magnitude(bins[0]) + tiny), logf(magnitude(bins[1]) + tiny),
+                logf(magnitude(bins[2]) + tiny));
+        break;
+    }
+    }
+    return offset < -1 ? -1 : offset > 1 ? 1 : offset;
+}
+
+float peakEstimatorGain(PeakEstimator estimator) {
+    const float gains[] = { 10.0f, 25.0f, 100.0f, 100.0f };
+    return gains[estimator];
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PeakEstimator_HPP_
+#define PeakEstimator_HPP_
+
+#include "kiss_fft.h"
+#include "windowing.hpp"
+
+/*
+ * Ways of placing a sinusoid between the bins of its spectral peak. The parabolic fit
+ * is biased by up to a tenth of a bin, which is why precision used to come from long
+ * FFTs alone; the others place a clean peak to a few thousandths of a bin, so that short
+ * FFTs resolve cents as well.
+ */
+enum PeakEstimator {
+    // Parabola through the linear magnitudes of the peak and its neighbours
+    ParabolicPeakEstimator,
+    // Parabola through their log powers, exact for a Gaussian shaped peak
+    GaussianPeakEstimator,
+    // Quinn's second estimator, from the ratios of the complex bins
+    QuinnPeakEstimator,
+    // Jain's method, from the magnitude ratio of the peak and its stronger neighbour
+    JainPeakEstimator,
+    PeakEstimatorCount
+};
+
+// Estimator of the FFT peak detector unless another one is asked for. Set it for a
+// build with e.g. DEFINES += PEAK_DEFAULT_ESTIMATOR=JainPeakEstimator.
+#ifndef PEAK_DEFAULT_ESTIMATOR
+#define PEAK_DEFAULT_ESTIMATOR QuinnPeakEstimator
+#endif
+
+const char* peakEstimatorName(PeakEstimator estimator);
+// Takes the names peakEstimatorName() gives, returns false for anything else
+bool parsePeakEstimator(const char* name, PeakEstimator* estimator);
+
+// Offset of the sinusoid from the peak bin in bins, between -1 and 1, given the complex
+// bins left of, at and right of the peak. Quinn's and Jain's estimators are derived for
+// the rectangular window; for a Hann window they use their window-corrected variants,
+// and for the other windows, whose main lobes are close to Gaussian, the Gaussian fit.
+float peakOffset(PeakEstimator estimator, WindowType window, const kiss_fft_cpx* bins);
+
+// Fraction of a bin the estimator places a Hann windowed peak to with some noise and
+// harmonics around, the interpolation gain of ResolutionController
+float peakEstimatorGain(PeakEstimator estimator);
+
+#endif /* PeakEstimator_HPP_ */
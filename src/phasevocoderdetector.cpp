@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "phasevocoderdetector.hpp"
+
+#include <math.h>
+#include <time.h>
+#include "peakestimator.hpp"
+
+// Wraps a phase into [-pi, pi)
+static double principalArgument(double phase) {
+    return phase - 2*M_PI*floor((phase + M_PI)/(2*M_PI));
+}
+
+PhaseVocoderDetector::PhaseVocoderDetector(int sampleRate, size_t frameSize, size_t bassFrameSize, size_t hop)
+    : sampleRate(sampleRate), hop(hop) {
+    resolutions[ShortResolution].size = frameSize;
+    resolutions[BassResolution].size = bassFrameSize;
+    for (int r = 0; r < ResolutionTypeCount; r++) {
+        Resolution& res = resolutions[r];
+        res.plan = FftPlanCache::shared()->plan(res.size);
+        res.window = WindowCache::shared()->table(HannWindow, res.size);
+        res.windowSum = 0;
+        for (size_t i = 0; i < res.size; i++)
+            res.windowSum += res.window[i];
+        res.peakPicker = new SpectralPeakPicker(res.size/2 + 1);
+        res.harmonics = new HarmonicAnalyser(sampleRate, res.size);
+    }
+    fftWorkspace = new FftWorkspace();
+    fftWorkspace->reserve(qMax(frameSize, bassFrameSize));
+    windowSamples = windowKernel();
+    reset();
+}
+
+PhaseVocoderDetector::~PhaseVocoderDetector() {
+    delete fftWorkspace;
+    for (int r = 0; r < ResolutionTypeCount; r++) {
+        delete resolutions[r].peakPicker;
+        delete resolutions[r].harmonics;
+    }
+}
+
+void PhaseVocoderDetector::reset() {
+    currentResolution = ShortResolution;
+    started = false;
+    lastPosition = 0;
+    historySize = 0;
+    historyEnd = 0;
+    trackSize = 0;
+    newestFound = false;
+}
+
+const PhaseVocoderFrame* PhaseVocoderDetector::frames(size_t* count) const {
+    *count = trackSize;
+    return track;
+}
+
+bool PhaseVocoderDetector::detect(const RingBuffer<short>* samples, PitchEstimate* estimate) {
+    unsigned int newest = samples->written();
+    trackSize = 0;
+
+    // Frames continue a hop after the last one. Without one, or too far behind for the
+    // samples to still be there, the track starts again from the newest samples.
+    size_t backlog = qMin(size_t(PHASE_VOCODER_MAX_FRAMES - 1)*hop, samples->capacity() - frameSize());
+    unsigned int position;
+    if (!started || newest - lastPosition > backlog + hop) {
+        position = newest - unsigned(backlog/hop*hop);
+        historySize = 0;
+    } else {
+        position = lastPosition + unsigned(hop);
+    }
+
+    // Without a new frame since the last detection its result stands
+    for (; int(newest - position) >= 0; position += unsigned(hop)) {
+        PhaseVocoderFrame frame;
+        newestFound = analyseFrame(samples, position, resolutions[currentResolution], &frame);
+        if (newestFound) {
+            // A change of frame length starts the phases afresh. Bass frames take over
+            // from the frame that found a low note, short ones only from the next.
+            float limit = PHASE_VOCODER_BASS_FREQ*(currentResolution == BassResolution ? PHASE_VOCODER_BASS_HYSTERESIS : 1.0f);
+            ResolutionType wanted = frame.frequency < limit ? BassResolution : ShortResolution;
+            if (wanted != currentResolution) {
+                currentResolution = wanted;
+                historySize = 0;
+                if (wanted == BassResolution)
+                    newestFound = analyseFrame(samples, position, resolutions[currentResolution], &frame);
+            }
+        }
+        if (newestFound) {
+            track[trackSize++] = frame;
+            newestEstimate.frequency = frame.frequency*frame.overtone;
+            newestEstimate.amplitude = frame.amplitude;
+            newestEstimate.overtone = frame.overtone;
+        }
+        lastPosition = position;
+        started = true;
+    }
+
+    // A reading stands for all the frames since the previous one that found the same
+    // peak, which also evens out beats with the partials of other notes
+    if (newestFound && trackSize > 1) {
+        float peakFreq = newestEstimate.frequency;
+        double sum = 0;
+        int count = 0;
+        for (size_t i = 0; i < trackSize; i++) {
+            float f = track[i].frequency*track[i].overtone;
+            if (fabs(f/peakFreq - 1) < PHASE_VOCODER_SAME_PEAK) {
+                sum += f;
+                count++;
+            }
+        }
+        newestEstimate.frequency = float(sum/count);
+    }
+    if (newestFound)
+        *estimate = newestEstimate;
+    return newestFound;
+}
+
+bool PhaseVocoderDetector::refine(const kiss_fft_cpx* freqData, size_t nfft, size_t bin,
+        unsigned int position, size_t hops, double* freq) const {
+    const PastFrame& past = history[(historyEnd + PHASE_VOCODER_HISTORY - hops) % PHASE_VOCODER_HISTORY];
+    if (bin + PHASE_VOCODER_KEPT_BINS < past.bin || bin > past.bin + PHASE_VOCODER_KEPT_BINS)
+        return false;
+    const kiss_fft_cpx& before = past.bins[bin + PHASE_VOCODER_KEPT_BINS - past.bin];
+    const kiss_fft_cpx& now = freqData[bin];
+
+    unsigned int advance = position - past.position;
+    double turned = atan2(now.i, now.r) - atan2(before.i, before.r);
+    double expected = 2*M_PI*(*freq)*advance/sampleRate;
+    double deviation = principalArgument(turned - expected)*sampleRate/(2*M_PI*advance);
+    // More than a bin off means the phases belong to different partials, or noise
+    if (fabs(deviation) >= float(sampleRate)/nfft)
+        return false;
+    *freq += deviation;
+    return true;
+}
+
+bool PhaseVocoderDetector::analyseFrame(const RingBuffer<short>* samples, unsigned int position,
+        const Resolution& resolution, PhaseVocoderFrame* frame) {
+    size_t nfft = resolution.size;
+    const float* window = resolution.window;
+    kiss_fft_scalar* timeData = fftWorkspace->timeData();
+    kiss_fft_cpx* freqData = fftWorkspace->freqData();
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    RingBuffer<short>::Span first, second;
+    samples->before(position, nfft, &first, &second);
+    windowSamples(first.data, window, timeData, first.size);
+    windowSamples(second.data, &window[first.size], &timeData[first.size], second.size);
+    resolution.plan->forward(timeData, freqData, fftWorkspace->scratch());
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    float fftSeconds = float(t1.tv_sec - t0.tv_sec) + float(t1.tv_nsec - t0.tv_nsec)/1000000000;
+
+    size_t minBin = qMax(size_t(PHASE_VOCODER_MIN_FREQ*nfft/sampleRate) + 1, size_t(PHASE_VOCODER_KEPT_BINS));
+    SpectralPeak peak;
+    bool found = resolution.peakPicker->find(freqData, minBin, nfft/2 - PHASE_VOCODER_KEPT_BINS, &peak, 1) > 0 &&
+            2*sqrt(peak.power)/resolution.windowSum >= PHASE_VOCODER_MIN_AMPLITUDE;
+    if (!found) {
+        historySize = 0;
+        return false;
+    }
+
+    size_t bin = peak.bin;
+    float binHz = float(sampleRate)/nfft;
+    double freq = (bin + peakOffset(QuinnPeakEstimator, HannWindow, &freqData[bin - 1]))*binHz;
+    frame->refined = false;
+
+    // For a stationary partial the phase of a bin advances by the same 2*pi*f*H/fs
+    // whichever bin it is, so an earlier frame's phase of this very bin is needed. The
+    // estimate has to be within fs/2H of the truth to tell the turns apart, so the
+    // advance over a hop refines it first, and that the advance over a longer baseline.
+    size_t hops = qMin(historySize, size_t(ceil(PHASE_VOCODER_BASELINE_BINS/bin)));
+    if (hops > 0 && refine(freqData, nfft, bin, position, 1, &freq)) {
+        frame->refined = true;
+        for (; hops > 1; hops--) {
+            if (refine(freqData, nfft, bin, position, hops, &freq))
+                break;
+        }
+    }
+
+    PastFrame& past = history[historyEnd];
+    past.position = position;
+    past.bin = bin;
+    for (int k = 0; k < 2*PHASE_VOCODER_KEPT_BINS + 1; k++)
+        past.bins[k] = freqData[bin - PHASE_VOCODER_KEPT_BINS + k];
+    historyEnd = (historyEnd + 1) % PHASE_VOCODER_HISTORY;
+    historySize = qMin(historySize + 1, size_t(PHASE_VOCODER_HISTORY));
+
+    frame->overtone = 1;
+#ifdef DETECT_OVERTONES
+    resolution.harmonics->setBudget(HARMONIC_BUDGET*fftSeconds);
+    frame->overtone = resolution.harmonics->harmonicOf(resolution.peakPicker->power(), float(freq));
+#endif
+    frame->position = position;
+    frame->frequency = float(freq)/frame->overtone;
+    frame->amplitude = 2*sqrt(peak.power)/resolution.windowSum;
+    return true;
+}
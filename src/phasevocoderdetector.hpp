@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PhaseVocoderDetector_HPP_
+#define PhaseVocoderDetector_HPP_
+
+#include "kiss_fft.h"
+#include "fftplancache.hpp"
+#include "harmonicanalyser.hpp"
+#include "pitchdetector.hpp"
+#include "spectralpeaks.hpp"
+#include "windowing.hpp"
+
+#define PHASE_VOCODER_FRAME_SIZE 2048
+// Frames for notes whose harmonics are too close together for the short ones: below
+// PHASE_VOCODER_BASS_FREQ, and back to short frames only a little above it
+#define PHASE_VOCODER_BASS_FRAME_SIZE 4096
+#define PHASE_VOCODER_BASS_FREQ 100.0f
+#define PHASE_VOCODER_BASS_HYSTERESIS 1.1f
+// Samples between the frames of the track, about 170 frames a second at 44.1 kHz
+#define PHASE_VOCODER_HOP 256
+// Most frames analysed by one detect(). When the analysis falls further behind, the
+// older frames are skipped.
+#define PHASE_VOCODER_MAX_FRAMES 32
+// Frames whose peaks are within this ratio of the newest one's, about half a semitone,
+// make up a reading together
+#define PHASE_VOCODER_SAME_PEAK 0.03f
+#define PHASE_VOCODER_MIN_FREQ 20.0f
+// Peaks weaker than this (sine amplitude in S16 sample units) count as silence
+#define PHASE_VOCODER_MIN_AMPLITUDE 20.0f
+// Bins either side of the peak whose phases are kept for later frames, so the peak
+// may move this far and still be refined
+#define PHASE_VOCODER_KEPT_BINS 2
+// Frames kept for their phases. The phase advance of a peak near 0 Hz is disturbed by
+// its mirror image at negative frequencies, so it is measured over a number of hops
+// that grows as the peak bin gets lower: PHASE_VOCODER_BASELINE_BINS over the bin, up
+// to the history.
+#define PHASE_VOCODER_HISTORY 16
+#define PHASE_VOCODER_BASELINE_BINS 16.0f
+
+// One frame of the track
+struct PhaseVocoderFrame {
+    // RingBuffer::written() as of the newest sample of the frame
+    unsigned int position;
+    // Of the fundamental
+    float frequency;
+    float amplitude;
+    int overtone;
+    // Whether the phase advance refined the frequency. Otherwise it comes from the
+    // frame's own spectrum only, e.g. at the start of a note.
+    bool refined;
+};
+
+/*
+ * Tracks the pitch through short, heavily overlapping frames taken every
+ * PHASE_VOCODER_HOP samples, however often detect() is called. Each frame's peak is
+ * placed between bins with Quinn's estimator, and then refined from how far the phase
+ * of the peak bin advanced since an earlier frame: over a hop of H samples a partial
+ * at f turns by 2*pi*f*H/fs, so the deviation of the measured advance from the one the
+ * estimate predicts gives the frequency to a small fraction of a bin. Precision comes
+ * from the hop rather than the frame length, which keeps frames short and the track
+ * close to the vibrato actually played. Only notes too low to have their harmonics
+ * apart in a short frame get longer ones, and their phase advance is measured over
+ * several hops, see PHASE_VOCODER_BASELINE_BINS.
+ *
+ * A detection returns the mean of the frames it analysed on the newest frame's peak,
+ * and every frame it analysed is available through frames() until the next one.
+ */
+class PhaseVocoderDetector : public PitchDetector {
+public:
+    PhaseVocoderDetector(int sampleRate, size_t frameSize = PHASE_VOCODER_FRAME_SIZE,
+            size_t bassFrameSize = PHASE_VOCODER_BASS_FRAME_SIZE, size_t hop = PHASE_VOCODER_HOP);
+    virtual ~PhaseVocoderDetector();
+
+    virtual const char* name() const { return "vocoder"; }
+    // The longest frame, which is what it needs of the samples
+    virtual size_t frameSize() const { return resolutions[BassResolution].size; }
+    virtual bool detect(const RingBuffer<short>* samples, PitchEstimate* estimate);
+
+    size_t hopSize() const { return hop; }
+    // Frames with a pitch that the last detect() analysed, oldest first
+    const PhaseVocoderFrame* frames(size_t* count) const;
+    // Starts the track afresh, e.g. before analysing an unrelated recording
+    void reset();
+
+private:
+    PhaseVocoderDetector(const PhaseVocoderDetector&);
+    PhaseVocoderDetector& operator=(const PhaseVocoderDetector&);
+
+    enum ResolutionType {
+        ShortResolution,
+        BassResolution,
+        ResolutionTypeCount
+    };
+
+    // What frames of one length are analysed with
+    struct Resolution {
+        size_t size;
+        const FftPlan* plan;
+        const float* window;
+        float windowSum;
+        SpectralPeakPicker* peakPicker;
+        HarmonicAnalyser* harmonics;
+    };
+
+    // Analyses the frame ending at position. Returns false if it holds no pitch.
+    bool analyseFrame(const RingBuffer<short>* samples, unsigned int position, const Resolution& resolution,
+            PhaseVocoderFrame* frame);
+    // Corrects *freq by the phase advance of bin since the frame the given number of
+    // hops back. Returns false if that frame's peak was too far from bin or the
+    // correction is implausible.
+    bool refine(const kiss_fft_cpx* freqData, size_t nfft, size_t bin, unsigned int position,
+            size_t hops, double* freq) const;
+
+    int sampleRate;
+    size_t hop;
+    Resolution resolutions[ResolutionTypeCount];
+    ResolutionType currentResolution;
+    FftWorkspace* fftWorkspace;
+    WindowKernel windowSamples;
+
+    // End of the last frame analysed
+    bool started;
+    unsigned int lastPosition;
+    // Peaks of the latest frames in a row that had one at the current resolution, and
+    // the bins around them
+    struct PastFrame {
+        unsigned int position;
+        size_t bin;
+        kiss_fft_cpx bins[2*PHASE_VOCODER_KEPT_BINS + 1];
+    };
+    PastFrame history[PHASE_VOCODER_HISTORY];
+    // Frames in the history, the newest at historyEnd - 1 modulo its size
+    size_t historySize;
+    size_t historyEnd;
+
+    PhaseVocoderFrame track[PHASE_VOCODER_MAX_FRAMES];
+    size_t trackSize;
+    // Whether the newest frame had a pitch, and which
+    bool newestFound;
+    PitchEstimate newestEstimate;
+};
+
+#endif /* PhaseVocoderDetector_HPP_ */
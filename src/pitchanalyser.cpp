@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pitchanalyser.hpp"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+// Octaves are counted from A, like the tuning frequency
+static const char* noteNames[] = { "A", "A#", "B", "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#" };
+
+PitchAnalyser::PitchAnalyser(int sampleRate, int tuningFreq, size_t fftSize, FftScalarType fftScalar) {
+    this->sampleRate = sampleRate;
+    this->tuningFreq = tuningFreq;
+    silentReadCount = 0;
+    spectrumSize = 0;
+
+    // All detectors are set up front so that switching between them at runtime
+    // does not allocate on the analysis thread
+    fftPeak = new FftPeakDetector(sampleRate, fftSize, fftScalar);
+    detectors[FftPeakPitchDetector] = fftPeak;
+    detectors[YinPitchDetector] = new YinDetector(sampleRate);
+    detectors[ZoomFftPitchDetector] = new ZoomFftDetector(sampleRate);
+    strobe = new StrobeDetector(sampleRate);
+    detectors[StrobePitchDetector] = strobe;
+    vocoder = new PhaseVocoderDetector(sampleRate);
+    detectors[PhaseVocoderPitchDetector] = vocoder;
+    track = new RingBuffer<PitchTrackPoint>(PITCH_TRACK_CAPACITY);
+    detector = detectors[FftPeakPitchDetector];
+
+    targetNote = 69;
+    requestedTargetNote.fetchAndStoreRelaxed(targetNote);
+    strobe->setTarget(tuningFreq);
+
+    resolution = new ResolutionController(sampleRate, FFT_PEAK_MIN_SIZE, fftSize);
+    requestedPrecision.fetchAndStoreRelaxed(int(RESOLUTION_PRECISION_CENTS*100));
+    requestedEstimator.fetchAndStoreRelaxed(fftPeak->peakEstimator());
+    resolution->setInterpolationGain(peakEstimatorGain(fftPeak->peakEstimator()));
+    requestedLockReadings.fetchAndStoreRelaxed(stabiliser.lockReadings());
+}
+
+PitchAnalyser::~PitchAnalyser() {
+    for (int i = 0; i < PitchDetectorTypeCount; i++)
+        delete detectors[i];
+    delete track;
+    delete resolution;
+}
+
+void PitchAnalyser::clearNote(NoteInfo* note) {
+    note->note[0] = 0;
+    note->centsDiff = 0.0f;
+    note->amplitude = 0.0f;
+    note->frequency = 0.0f;
+    note->harmonic = 0;
+    note->channel = 0;
+    note->confidence = 0.0f;
+    note->timing.captured = 0;
+    note->timing.analysisStarted = 0;
+    note->timing.analysisFinished = 0;
+}
+
+NoteInfo PitchAnalyser::gatedNote() {
+    struct NoteInfo note;
+    clearNote(&note);
+    silentReadCount++;
+    spectrumSize = 0;
+    stabiliser.miss();
+    return note;
+}
+
+NoteInfo PitchAnalyser::getNote(const RingBuffer<short>* samples) {
+    struct NoteInfo note;
+    clearNote(&note);
+
+    // Switch detectors between readings only, never in the middle of one
+    detector = detectors[requestedDetector.fetchAndAddAcquire(0)];
+    int requestedNote = requestedTargetNote.fetchAndAddAcquire(0);
+    if (requestedNote != targetNote) {
+        targetNote = requestedNote;
+        strobe->setTarget(tuningFreq*pow(2.0f, (targetNote - 69)/12.0f));
+    }
+    stabiliser.setLockReadings(requestedLockReadings.fetchAndAddAcquire(0));
+    PeakEstimator estimator = PeakEstimator(requestedEstimator.fetchAndAddAcquire(0));
+    if (estimator != fftPeak->peakEstimator()) {
+        fftPeak->setEstimator(estimator);
+        resolution->setInterpolationGain(peakEstimatorGain(estimator));
+    }
+
+    // The size may change with the reading, see adaptFftSize()
+    spectrumSize = detector == fftPeak ? fftPeak->frameSize() : 0;
+
+    PitchEstimate estimate;
+    bool detected = detector->detect(samples, &estimate);
+    if (detector == vocoder)
+        extendPitchTrack();
+    if (detected) {
+        float adjustedFreq = estimate.frequency;
+        int overtone = estimate.overtone;
+        silentReadCount = 0;
+
+        // Sanity check to filter out unstable readings. If reading is not stable, return an empty note
+        bool saneFreqRange = adjustedFreq >= 20 && adjustedFreq <= 22000;
+        if (saneFreqRange) {
+            if (stabiliser.update(1200*log2(adjustedFreq/overtone/tuningFreq)))
+                convertCentsToNote(stabiliser.cents(), stabiliser.semitone(), estimate.amplitude, overtone, &note);
+            note.confidence = stabiliser.confidence();
+        } else {
+            stabiliser.miss();
+        }
+        if (detector == fftPeak) {
+            float stableFreq = stabiliser.isLocked() ? tuningFreq*pow(2.0f, stabiliser.cents()/1200) : 0.0f;
+            adaptFftSize(stableFreq);
+        }
+    } else {
+        // No usable pitch, most likely silence
+        silentReadCount++;
+        stabiliser.miss();
+    }
+
+    return note;
+}
+
+void PitchAnalyser::extendPitchTrack() {
+    size_t count;
+    const PhaseVocoderFrame* frames = vocoder->frames(&count);
+    for (size_t i = 0; i < count; i++) {
+        trackPoints[i].position = frames[i].position;
+        trackPoints[i].cents = 1200*log2(frames[i].frequency/tuningFreq);
+        trackPoints[i].amplitude = frames[i].amplitude;
+        trackPoints[i].refined = frames[i].refined;
+    }
+    track->write(trackPoints, count);
+}
+
+void PitchAnalyser::adaptFftSize(float stableFreq) {
+    float precision = requestedPrecision.fetchAndAddAcquire(0)/100.0f;
+    if (precision <= 0) {
+        resolution->reset();
+    } else {
+        resolution->setPrecision(precision);
+        if (stableFreq > 0)
+            resolution->update(stableFreq);
+        else
+            resolution->unstable();
+    }
+    fftPeak->setFftSize(resolution->size());
+}
+
+void PitchAnalyser::reset() {
+    stabiliser.reset();
+    silentReadCount = 0;
+    vocoder->reset();
+    strobe->reset();
+    resolution->reset();
+    fftPeak->setFftSize(resolution->size());
+}
+
+void PitchAnalyser::setDetector(PitchDetectorType type) {
+    if (type >= 0 && type < PitchDetectorTypeCount)
+        requestedDetector.fetchAndStoreRelease(type);
+}
+
+void PitchAnalyser::setTargetNote(int note) {
+    requestedTargetNote.fetchAndStoreRelease(note);
+}
+
+void PitchAnalyser::setPrecision(float cents) {
+    requestedPrecision.fetchAndStoreRelease(int(cents*100));
+}
+
+void PitchAnalyser::setPeakEstimator(PeakEstimator estimator) {
+    if (estimator >= 0 && estimator < PeakEstimatorCount)
+        requestedEstimator.fetchAndStoreRelease(estimator);
+}
+
+void PitchAnalyser::setLockReadings(int readings) {
+    requestedLockReadings.fetchAndStoreRelease(readings);
+}
+
+int PitchAnalyser::silentReadings() const {
+    return silentReadCount;
+}
+
+const float* PitchAnalyser::powerSpectrum(size_t* bins, float* binHz) const {
+    if (spectrumSize == 0)
+        return NULL;
+    *bins = spectrumSize/2 + 1;
+    *binHz = float(sampleRate)/spectrumSize;
+    return fftPeak->power();
+}
+
+PitchDetectorType PitchAnalyser::detectorType() const {
+    return PitchDetectorType(requestedDetector.fetchAndAddAcquire(0));
+}
+
+size_t PitchAnalyser::frameSize() const {
+    return detectors[requestedDetector.fetchAndAddAcquire(0)]->frameSize();
+}
+
+void PitchAnalyser::convertFreqToNote(float f, float a, int overtone, struct NoteInfo* description) {
+	float cents = 1200*log2((f/overtone)/tuningFreq);
+	convertCentsToNote(cents, int(floor(cents/100 + 0.5f)), a, overtone, description);
+	description->frequency = f;
+}
+
+void PitchAnalyser::convertCentsToNote(float cents, int semitone, float a, int overtone, struct NoteInfo* description) {
+	int octave = 4 + int(floor(semitone/12.0f));
+	int noteNumber = semitone - 12*(octave - 4);
+	sprintf(description->note, "%s%d", noteNames[noteNumber], octave);
+	description->centsDiff = cents - 100*semitone;
+	description->frequency = tuningFreq*pow(2.0f, cents/1200)*overtone;
+	description->amplitude = a;
+	description->harmonic = overtone;
+}
+
+bool parseNoteName(const char* name, int* note) {
+    char* end;
+    if (isdigit(name[0])) {
+        long number = strtol(name, &end, 10);
+        if (*end != '\0' || number > 127)
+            return false;
+        *note = int(number);
+        return true;
+    }
+    // Longest name first, so that A# is not taken for A
+    for (int i = 11; i >= 0; i--) {
+        size_t length = strlen(noteNames[i]);
+        if (strncmp(name, noteNames[i], length) != 0 || !isdigit(name[length]))
+            continue;
+        long octave = strtol(&name[length], &end, 10);
+        int number = 69 + i + 12*(int(octave) - 4);
+        if (*end != '\0' || number < 0 || number > 127)
+            return false;
+        *note = number;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PitchAnalyser_HPP_
+#define PitchAnalyser_HPP_
+
+#include <QAtomicInt>
+#include <QtGlobal>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "fftpeakdetector.hpp"
+#include "fftscalar.hpp"
+#include "noteinfo.hpp"
+#include "phasevocoderdetector.hpp"
+#include "pitchdetector.hpp"
+#include "pitchstabiliser.hpp"
+#include "resolutioncontroller.hpp"
+#include "ringbuffer.hpp"
+#include "strobedetector.hpp"
+#include "yindetector.hpp"
+#include "zoomfftdetector.hpp"
+
+// Points of the pitch track kept for its readers, several seconds at the vocoder's hop
+#define PITCH_TRACK_CAPACITY 1024
+
+// One frame of the high rate pitch track, see PitchAnalyser::pitchTrack()
+struct PitchTrackPoint {
+    // RingBuffer::written() of the analysed samples as of the newest sample of the frame
+    unsigned int position;
+    // Fundamental in cents from the tuning frequency
+    float cents;
+    float amplitude;
+    // See PhaseVocoderFrame::refined
+    bool refined;
+};
+
+/*
+ * Turns the newest samples of a capture ring buffer into a NoteInfo. The fundamental
+ * frequency comes from one of several PitchDetectors, which can be switched at runtime;
+ * the analyser itself decides whether the readings are stable, see PitchStabiliser, and
+ * does the note conversion. Apart from the setters an analyser must only be used from
+ * one thread at a time.
+ *
+ * The FFT peak detector's size follows the register being played, see
+ * ResolutionController. The fftSize given to the constructor is the largest it uses,
+ * fftScalar the arithmetic it computes its spectrum in.
+ *
+ * With the phase vocoder detector every frame it analyses, not just the newest, also
+ * goes into a pitch track, unfiltered by the stabiliser.
+ */
+class PitchAnalyser {
+public:
+    PitchAnalyser(int sampleRate, int tuningFreq, size_t fftSize,
+            FftScalarType fftScalar = FFT_DEFAULT_SCALAR);
+    ~PitchAnalyser();
+
+    // Takes effect with the next reading, safe to call from any thread
+    void setDetector(PitchDetectorType type);
+    PitchDetectorType detectorType() const;
+
+    // Note the strobe detector listens for, as a MIDI note number (69 is A4). Takes
+    // effect with the next reading, safe to call from any thread.
+    void setTargetNote(int note);
+
+    // Precision in cents the FFT size is chosen for, 0 keeps it at its largest. Takes
+    // effect with the next reading, safe to call from any thread.
+    void setPrecision(float cents);
+
+    // Estimator the FFT peak detector places peaks between bins with, which also decides
+    // how small its FFT can get. Takes effect with the next reading, safe to call from
+    // any thread.
+    void setPeakEstimator(PeakEstimator estimator);
+
+    // Readings in a row that have to agree before a note is given, see PitchStabiliser.
+    // Takes effect with the next reading, safe to call from any thread.
+    void setLockReadings(int readings);
+
+    size_t frameSize() const;
+
+    // Forgets the reading history, e.g. before analysing an unrelated recording
+    void reset();
+
+    NoteInfo getNote(const RingBuffer<short>* samples);
+    // Reading for a frame the silence gate kept from analysis, an empty note
+    NoteInfo gatedNote();
+    // Number of readings in a row that found no pitch at all, 0 after one that did
+    int silentReadings() const;
+    // Power spectrum the last reading was made from, with its number of bins and their
+    // spacing. NULL unless the reading came from the FFT peak detector.
+    const float* powerSpectrum(size_t* bins, float* binHz) const;
+    // Frames of the phase vocoder detector as they are analysed, a point every
+    // pitchTrackHop() samples while there is a pitch. Readers on other threads follow
+    // it by RingBuffer::written(), like the capture buffers.
+    const RingBuffer<PitchTrackPoint>* pitchTrack() const { return track; }
+    size_t pitchTrackHop() const { return vocoder->hopSize(); }
+
+    // Fills in the note name and cents for frequency f, which is the given harmonic
+    // of the note
+    void convertFreqToNote(float f, float a, int harmonic, struct NoteInfo*);
+    // The same for a fundamental given in cents from the tuning frequency, named as the
+    // note semitones away from it
+    void convertCentsToNote(float cents, int semitone, float a, int harmonic, struct NoteInfo*);
+
+private:
+    PitchAnalyser(const PitchAnalyser&);
+    PitchAnalyser& operator=(const PitchAnalyser&);
+
+    // Takes the fundamental of the reading, 0 if it was unstable
+    void adaptFftSize(float stableFreq);
+    // Appends the frames of the vocoder's last detection to the track
+    void extendPitchTrack();
+    static void clearNote(NoteInfo* note);
+
+private:
+    PitchStabiliser stabiliser;
+    QAtomicInt requestedLockReadings;
+    int silentReadCount;
+
+    int tuningFreq;
+    int sampleRate;
+
+    PitchDetector* detectors[PitchDetectorTypeCount];
+    PitchDetector* detector;
+    mutable QAtomicInt requestedDetector;
+
+    StrobeDetector* strobe;
+    int targetNote;
+    QAtomicInt requestedTargetNote;
+
+    PhaseVocoderDetector* vocoder;
+    RingBuffer<PitchTrackPoint>* track;
+    PitchTrackPoint trackPoints[PHASE_VOCODER_MAX_FRAMES];
+
+    FftPeakDetector* fftPeak;
+    // FFT size of the last reading's spectrum, 0 if it had none
+    size_t spectrumSize;
+    ResolutionController* resolution;
+    // In hundredths of a cent
+    QAtomicInt requestedPrecision;
+    QAtomicInt requestedEstimator;
+};
+
+// Takes a MIDI note number or a note name the way readings are named, e.g. E1 or A#3
+// with octaves counted from A, returns false for anything else
+bool parseNoteName(const char* name, int* note);
+
+#endif /* PitchAnalyser_HPP_ */
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "pitchdetector.hpp"
+
+#include <string.h>
+
+const char* pitchDetectorName(PitchDetectorType type) {
+    const char* names[] = { "fft", "yin", "zoom", "strobe", "vocoder" };
+    return names[type];
+}
+
+bool parsePitchDetector(const char* name, PitchDetectorType* type) {
+    for (int i = 0; i < PitchDetectorTypeCount; i++) {
+        if (strcmp(name, pitchDetectorName(PitchDetectorType(i))) == 0) {
+            *type = PitchDetectorType(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PitchDetector_HPP_
+#define PitchDetector_HPP_
+
+#include <stddef.h>
+#include "ringbuffer.hpp"
+
+// Detectors that see a full spectrum check whether their peak is an overtone
+#define DETECT_OVERTONES
+
+enum PitchDetectorType {
+    FftPeakPitchDetector,
+    YinPitchDetector,
+    ZoomFftPitchDetector,
+    StrobePitchDetector,
+    // Short frames refined by the phase advance between them, for a high rate pitch
+    // track, see PhaseVocoderDetector
+    PhaseVocoderPitchDetector,
+    PitchDetectorTypeCount
+};
+
+const char* pitchDetectorName(PitchDetectorType type);
+// Takes the names pitchDetectorName() gives, returns false for anything else
+bool parsePitchDetector(const char* name, PitchDetectorType* type);
+
+struct PitchEstimate {
+    float frequency;
+    float amplitude;
+    int overtone;
+};
+
+/*
+ * Estimates the fundamental frequency from the newest samples in the capture buffer.
+ * PitchAnalyser dispatches through this interface and does the note conversion and
+ * stability checks itself, so detectors only need to produce a frequency.
+ */
+class PitchDetector {
+public:
+    virtual ~PitchDetector() {}
+
+    virtual const char* name() const = 0;
+
+    // Number of newest samples a single detection looks at
+    virtual size_t frameSize() const = 0;
+
+    // Returns false if the frame holds no usable pitch, e.g. silence
+    virtual bool detect(const RingBuffer<short>* samples, PitchEstimate* estimate) = 0;
+};
+
+#endif /* PitchDetector_HPP_ */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pitchstabiliser.hpp"
+
+#include <math.h>
+
+PitchStabiliser::PitchStabiliser() {
+    lockCount = STABILITY_LOCK_READINGS;
+    reset();
+}
+
+void PitchStabiliser::setLockReadings(int readings) {
+    lockCount = readings < 1 ? 1 : readings;
+    if (agreeing > lockCount)
+        agreeing = lockCount;
+}
+
+void PitchStabiliser::reset() {
+    readingCount = 0;
+    nextReading = 0;
+    tracking = false;
+    estimate = 0;
+    variance = STABILITY_MEASUREMENT_NOISE;
+    agreeing = 0;
+    locked = false;
+    heldSemitone = 0;
+}
+
+float PitchStabiliser::confidence() const {
+    return float(agreeing)/lockCount;
+}
+
+float PitchStabiliser::median() const {
+    float sorted[STABILITY_MEDIAN_SIZE];
+    for (int i = 0; i < readingCount; i++) {
+        int j = i;
+        for (; j > 0 && sorted[j-1] > readings[i]; j--)
+            sorted[j] = sorted[j-1];
+        sorted[j] = readings[i];
+    }
+    if (readingCount % 2 == 1 || !tracking)
+        return sorted[readingCount/2];
+    // Of the two in the middle, the one that agrees better with what we have
+    float lower = sorted[readingCount/2 - 1];
+    float upper = sorted[readingCount/2];
+    return fabs(lower - estimate) <= fabs(upper - estimate) ? lower : upper;
+}
+
+void PitchStabiliser::restart(float cents) {
+    estimate = cents;
+    variance = STABILITY_MEASUREMENT_NOISE;
+    tracking = true;
+    locked = false;
+    heldSemitone = int(floor(cents/100 + 0.5f));
+
+    // Earlier readings that agree with the new note count towards its lock, the latest
+    // one is counted by the caller
+    agreeing = 0;
+    int latest = (nextReading + STABILITY_MEDIAN_SIZE - 1) % STABILITY_MEDIAN_SIZE;
+    for (int i = 0; i < readingCount; i++) {
+        if (i != latest && fabs(readings[i] - cents) <= STABILITY_TOLERANCE_CENTS)
+            agreeing++;
+    }
+    if (agreeing > lockCount - 1)
+        agreeing = lockCount - 1;
+}
+
+bool PitchStabiliser::update(float cents) {
+    readings[nextReading] = cents;
+    nextReading = (nextReading + 1) % STABILITY_MEDIAN_SIZE;
+    if (readingCount < STABILITY_MEDIAN_SIZE)
+        readingCount++;
+
+    // Start over on a new note, and when nothing agrees with the estimate any more,
+    // e.g. because the pitch has slid away from it
+    float m = median();
+    float innovation = cents - estimate;
+    if (!tracking || fabs(m - estimate) > STABILITY_JUMP_CENTS ||
+            (agreeing == 0 && fabs(innovation) > STABILITY_TOLERANCE_CENTS))
+        restart(m);
+
+    innovation = cents - estimate;
+    if (fabs(innovation) <= STABILITY_TOLERANCE_CENTS) {
+        variance += STABILITY_PROCESS_NOISE;
+        float gain = variance/(variance + STABILITY_MEASUREMENT_NOISE);
+        estimate += gain*innovation;
+        variance *= 1 - gain;
+        if (agreeing < lockCount)
+            agreeing++;
+    } else if (agreeing > 0) {
+        // An outlier, it uses up some of the lock but does not move the estimate
+        agreeing--;
+    }
+
+    if (agreeing >= lockCount)
+        locked = true;
+    else if (agreeing == 0)
+        locked = false;
+
+    if (fabs(estimate - heldSemitone*100) > 50 + STABILITY_NOTE_HYSTERESIS)
+        heldSemitone = int(floor(estimate/100 + 0.5f));
+
+    return locked;
+}
+
+void PitchStabiliser::miss() {
+    if (agreeing > 0)
+        agreeing--;
+    // Once the lock is used up the next note starts from scratch
+    if (agreeing == 0)
+        reset();
+}
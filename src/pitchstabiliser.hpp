@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PitchStabiliser_HPP_
+#define PitchStabiliser_HPP_
+
+// Readings the running median is taken over
+#define STABILITY_MEDIAN_SIZE 3
+// Readings that have to agree before a note is shown, unless set otherwise
+#define STABILITY_LOCK_READINGS 2
+// Cents from the estimate within which a reading agrees with it
+#define STABILITY_TOLERANCE_CENTS 35.0f
+// Cents the median has to move away from the estimate to count as a new note
+#define STABILITY_JUMP_CENTS 60.0f
+// Variances in cents squared of the Kalman filter: how far the pitch itself may drift
+// from one reading to the next, and how far a reading scatters around it
+#define STABILITY_PROCESS_NOISE 1.0f
+#define STABILITY_MEASUREMENT_NOISE 1.0f
+// Cents past the half-way point to the next note the pitch has to go before the note
+// shown changes
+#define STABILITY_NOTE_HYSTERESIS 15.0f
+
+/*
+ * Decides from a stream of readings whether there is a stable pitch, and smooths it.
+ * Each reading is the fundamental in cents from the tuning frequency, and costs the
+ * same whatever the history:
+ *
+ * - a running median over the last STABILITY_MEDIAN_SIZE readings tells a new note from
+ *   an outlier: the estimate only jumps once the median has moved,
+ * - a scalar Kalman filter smooths the readings that agree with the estimate,
+ * - the note is locked once lockReadings readings in a row agree, and unlocked only when
+ *   disagreeing or missing readings have used all of them up again, so a single outlier
+ *   does not blank the display. Once unlocked by missing readings, the next note starts
+ *   from scratch,
+ * - the note shown changes only when the pitch goes clearly past the half-way point to
+ *   the next one.
+ */
+class PitchStabiliser {
+public:
+    PitchStabiliser();
+
+    // 1 shows the first reading of a note right away
+    void setLockReadings(int readings);
+    int lockReadings() const { return lockCount; }
+
+    // Takes a reading with a pitch, returns whether a note is locked
+    bool update(float cents);
+    // Takes a reading without a usable pitch
+    void miss();
+    void reset();
+
+    bool isLocked() const { return locked; }
+    // Share of the agreeing readings a lock needs that the latest ones provide, 0 to 1
+    float confidence() const;
+    // Smoothed pitch in cents from the tuning frequency
+    float cents() const { return estimate; }
+    // Note held by the hysteresis, in semitones from the tuning frequency
+    int semitone() const { return heldSemitone; }
+
+private:
+    PitchStabiliser(const PitchStabiliser&);
+    PitchStabiliser& operator=(const PitchStabiliser&);
+
+    float median() const;
+    void restart(float cents);
+
+    int lockCount;
+
+    float readings[STABILITY_MEDIAN_SIZE];
+    int readingCount;
+    int nextReading;
+
+    bool tracking;
+    float estimate;
+    float variance;
+    int agreeing;
+    bool locked;
+    int heldSemitone;
+};
+
+#endif /* PitchStabiliser_HPP_ */
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "qnxcapturebackend.hpp"
+
+#if defined(HAVE_QNX_CAPTURE)
+
+#include <QtGlobal>
+#include <string.h>
+#include <sys/select.h>
+
+QnxCaptureBackend::QnxCaptureBackend(const char* device, int sampleRate, int channels)
+    : rate(sampleRate), voices(channels) {
+    strncpy(this->device, device, sizeof(this->device) - 1);
+    this->device[sizeof(this->device) - 1] = 0;
+    pcmHandle = NULL;
+    pcmfd = -1;
+    fragSize = 0;
+    fragBuff = NULL;
+}
+
+QnxCaptureBackend::~QnxCaptureBackend() {
+    close();
+}
+
+bool QnxCaptureBackend::open() {
+	int rtn;
+	snd_pcm_info_t pcmInfo;
+	snd_pcm_channel_info_t pcmChannelInfo;
+	snd_pcm_channel_params_t pcmParams;
+
+	if ((rtn = snd_pcm_open_name(&pcmHandle, device, SND_PCM_OPEN_CAPTURE)) < 0) {
+		qDebug("snd_pcm_open_name failed: %s\n", snd_strerror(rtn));
+		pcmHandle = NULL;
+		return false;
+	}
+
+	if ((rtn = snd_pcm_info(pcmHandle, &pcmInfo)) < 0) {
+		qDebug("snd_pcm_info failed: %s\n", snd_strerror(rtn));
+		close();
+		return false;
+	}
+	qDebug("Capturing from card %d", pcmInfo.card);
+
+	memset(&pcmChannelInfo, 0, sizeof(pcmChannelInfo));
+	pcmChannelInfo.channel = SND_PCM_CHANNEL_CAPTURE;
+	if ((rtn = snd_pcm_plugin_info(pcmHandle, &pcmChannelInfo)) < 0) {
+		qDebug("snd_pcm_plugin_info failed: %s\n", snd_strerror(rtn));
+		close();
+		return false;
+	}
+
+	if (voices > pcmChannelInfo.max_voices) {
+		qDebug("Device has %d voices, capturing all of them", pcmChannelInfo.max_voices);
+		voices = pcmChannelInfo.max_voices;
+	}
+
+	memset(&pcmParams, 0, sizeof(pcmParams));
+
+	pcmParams.mode = SND_PCM_MODE_BLOCK;
+	pcmParams.channel = SND_PCM_CHANNEL_CAPTURE;
+	pcmParams.start_mode = SND_PCM_START_DATA;
+	pcmParams.stop_mode = SND_PCM_STOP_ROLLOVER;
+	pcmParams.buf.block.frag_size = pcmChannelInfo.max_fragment_size;
+
+	pcmParams.buf.block.frags_max = 0;
+	pcmParams.buf.block.frags_min = 1;
+
+	pcmParams.format.rate = rate;
+	// other format options: SND_PCM_SFMT_S32_LE SND_PCM_FMT_U16_LE SND_PCM_SFMT_S24
+	pcmParams.format.format = SND_PCM_SFMT_S16_LE;
+	pcmParams.format.voices = voices;
+
+	if ((rtn = snd_pcm_plugin_params(pcmHandle, &pcmParams)) < 0) {
+		qDebug("snd_pcm_plugin_params failed: %s\n", snd_strerror(rtn));
+		close();
+		return false;
+	}
+
+	fragSize = pcmParams.buf.block.frag_size;
+
+	if ((rtn = snd_pcm_channel_prepare(pcmHandle, SND_PCM_CHANNEL_CAPTURE)) < 0) {
+		qDebug("snd_pcm_channel_prepare failed: %s\n", snd_strerror(rtn));
+		close();
+		return false;
+	}
+
+	pcmfd = snd_pcm_file_descriptor(pcmHandle, SND_PCM_CHANNEL_CAPTURE);
+	fragBuff = new char[fragSize];
+	memset(fragBuff, 0, fragSize);
+	return true;
+}
+
+void QnxCaptureBackend::close() {
+	if (pcmHandle != NULL) {
+		int rtn;
+		if ((rtn = snd_pcm_close(pcmHandle)) < 0)
+			qDebug("snd_pcm_close failed: %s\n", snd_strerror(rtn));
+		pcmHandle = NULL;
+	}
+	delete[] fragBuff;
+	fragBuff = NULL;
+	pcmfd = -1;
+}
+
+// Flushing a capture channel discards what it holds and stops it, preparing it again
+// restarts it with the next read, with the parameters and buffers of open()
+bool QnxCaptureBackend::pause() {
+	int rtn;
+	if ((rtn = snd_pcm_plugin_flush(pcmHandle, SND_PCM_CHANNEL_CAPTURE)) < 0) {
+		qDebug("snd_pcm_plugin_flush failed: %s\n", snd_strerror(rtn));
+		return false;
+	}
+	return true;
+}
+
+bool QnxCaptureBackend::resume() {
+	int rtn;
+	if ((rtn = snd_pcm_plugin_prepare(pcmHandle, SND_PCM_CHANNEL_CAPTURE)) < 0) {
+		qDebug("snd_pcm_plugin_prepare failed: %s\n", snd_strerror(rtn));
+		return false;
+	}
+	return true;
+}
+
+int QnxCaptureBackend::overrunCount() const {
+    return overruns.fetchAndAddRelaxed(0);
+}
+
+int QnxCaptureBackend::capture(RingBuffer<short>* const* samples, int timeoutUs) {
+    fd_set readFds;
+    FD_ZERO(&readFds);
+    FD_SET(pcmfd, &readFds);
+    struct timeval timeout;
+    timeout.tv_sec = timeoutUs/1000000;
+    timeout.tv_usec = timeoutUs%1000000;
+
+    if (select(pcmfd + 1, &readFds, NULL, NULL, &timeout) <= 0 || !FD_ISSET(pcmfd, &readFds))
+        return 0;
+
+    ssize_t bytesRead = snd_pcm_read(pcmHandle, fragBuff, fragSize);
+    size_t frames = bytesRead > 0 ? bytesRead/(sizeof(short)*voices) : 0;
+
+    // Append read samples to the ring buffers, the oldest samples get overwritten
+    if (voices == 1)
+        samples[0]->write((const short*)fragBuff, frames);
+    else
+        writeInterleaved((const short*)fragBuff, frames, voices, samples, voices);
+    if (bytesRead < fragSize)
+        recoverFromOverrun();
+
+    return int(frames);
+}
+
+void QnxCaptureBackend::recoverFromOverrun() {
+    snd_pcm_channel_status_t status;
+    memset(&status, 0, sizeof(status));
+    status.channel = SND_PCM_CHANNEL_CAPTURE;
+
+    int rtn;
+    if ((rtn = snd_pcm_plugin_status(pcmHandle, &status)) < 0) {
+        qDebug("snd_pcm_plugin_status failed: %s\n", snd_strerror(rtn));
+        return;
+    }
+
+    if (status.status == SND_PCM_STATUS_READY || status.status == SND_PCM_STATUS_OVERRUN) {
+        overruns.ref();
+        if ((rtn = snd_pcm_plugin_prepare(pcmHandle, SND_PCM_CHANNEL_CAPTURE)) < 0)
+            qDebug("snd_pcm_plugin_prepare failed: %s\n", snd_strerror(rtn));
+    }
+}
+
+#endif
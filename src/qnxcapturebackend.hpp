@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef QnxCaptureBackend_HPP_
+#define QnxCaptureBackend_HPP_
+
+#if defined(__QNX__)
+#define HAVE_QNX_CAPTURE
+
+#include <QAtomicInt>
+#include <sys/asoundlib.h>
+#include "capturebackend.hpp"
+
+/*
+ * QNX io-audio capture through the snd_pcm_plugin_* API. The plugin layer only offers
+ * blocking reads, so each fragment is read into a staging buffer before it goes into
+ * the ring buffers. Several voices are captured interleaved and split into one ring
+ * buffer per voice.
+ */
+class QnxCaptureBackend : public CaptureBackend {
+public:
+    QnxCaptureBackend(const char* device, int sampleRate, int channels = 1);
+    virtual ~QnxCaptureBackend();
+
+    virtual const char* name() const { return "qnx"; }
+    virtual bool open();
+    virtual void close();
+    virtual bool pause();
+    virtual bool resume();
+    virtual int sampleRate() const { return rate; }
+    virtual int channelCount() const { return voices; }
+    virtual size_t fragmentSize() const { return fragSize/(sizeof(short)*voices); }
+    virtual int capture(RingBuffer<short>* const* samples, int timeoutUs);
+    virtual int overrunCount() const;
+
+private:
+    QnxCaptureBackend(const QnxCaptureBackend&);
+    QnxCaptureBackend& operator=(const QnxCaptureBackend&);
+
+    void recoverFromOverrun();
+
+    char device[64];
+    int rate;
+    int voices;
+    snd_pcm_t* pcmHandle;
+    int pcmfd;
+    int fragSize;
+    char* fragBuff;
+
+    mutable QAtomicInt overruns;
+};
+
+#endif
+
+#endif /* QnxCaptureBackend_HPP_ */
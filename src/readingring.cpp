@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "readingring.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Slots start on their own cache lines, so that writers of neighbouring frames do not
+// invalidate each other's lines, nor the readers' of the header
+#define READING_RING_ALIGNMENT 64
+
+static size_t aligned(size_t size) {
+    return (size + READING_RING_ALIGNMENT - 1) & ~size_t(READING_RING_ALIGNMENT - 1);
+}
+
+static size_t slotSize(size_t spectrumBins) {
+    return aligned(sizeof(ReadingRingSlot) + spectrumBins*sizeof(float));
+}
+
+static size_t ringSize(size_t slotCount, size_t slotSize) {
+    return aligned(sizeof(ReadingRingHeader)) + slotCount*slotSize;
+}
+
+static ReadingRingSlot* ringSlot(void* mapping, const ReadingRingLayout& layout, quint32 frame) {
+    return (ReadingRingSlot*)((char*)mapping + aligned(sizeof(ReadingRingHeader)) +
+            size_t(frame % layout.slotCount)*layout.slotSize);
+}
+
+ReadingRingWriter::ReadingRingWriter() : mapping(NULL), mappingSize(0), header(NULL) {
+    name[0] = 0;
+    memset(&layout, 0, sizeof(layout));
+}
+
+ReadingRingWriter::~ReadingRingWriter() {
+    close();
+}
+
+bool ReadingRingWriter::open(const char* name, int sampleRate, int channels, size_t spectrumBins) {
+    close();
+    if (strlen(name) >= sizeof(this->name))
+        return false;
+
+    // Readers still attached to a ring left behind keep their mapping, but nobody new
+    // finds it
+    shm_unlink(name);
+    // Readers need write access for their atomic loads, see ReadingRingReader, so
+    // nobody but this user gets any
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        qDebug("Cannot create reading ring %s: %s", name, strerror(errno));
+        return false;
+    }
+    layout.slotCount = READING_RING_SLOTS;
+    layout.slotSize = slotSize(spectrumBins);
+    layout.spectrumBins = spectrumBins;
+    size_t size = ringSize(layout.slotCount, layout.slotSize);
+    void* m = MAP_FAILED;
+    if (ftruncate(fd, off_t(size)) == 0)
+        m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        qDebug("Cannot map reading ring %s: %s", name, strerror(errno));
+        shm_unlink(name);
+        return false;
+    }
+    strcpy(this->name, name);
+    mapping = m;
+    mappingSize = size;
+
+    // The object comes zeroed, so every slot is empty and no frame is claimed. The
+    // magic goes in last, readers take the ring for one only after it.
+    header = (ReadingRingHeader*)mapping;
+    header->version = READING_RING_VERSION;
+    header->slotCount = quint32(layout.slotCount);
+    header->slotSize = quint32(layout.slotSize);
+    header->spectrumBins = quint32(layout.spectrumBins);
+    header->sampleRate = quint32(sampleRate);
+    header->channels = quint32(channels);
+    header->alive.fetchAndStoreOrdered(1);
+    memcpy(header->magic, READING_RING_MAGIC, sizeof(header->magic));
+    return true;
+}
+
+void ReadingRingWriter::close() {
+    if (mapping == NULL)
+        return;
+    header->alive.fetchAndStoreOrdered(0);
+    munmap(mapping, mappingSize);
+    shm_unlink(name);
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    name[0] = 0;
+}
+
+void ReadingRingWriter::publish(const NoteInfo& note, const float* power, size_t bins, float binHz) {
+    if (header == NULL)
+        return;
+    quint32 frame = quint32(header->claimed.fetchAndAddOrdered(1));
+    ReadingRingSlot* slot = ringSlot(mapping, layout, frame);
+
+    slot->sequence.fetchAndStoreOrdered(int(2*frame + 1));
+    slot->note = note;
+    slot->spectrumBins = 0;
+    slot->binHz = 0;
+    if (power != NULL && bins > 0 && binHz > 0 && layout.spectrumBins > 0) {
+        // Bins above the highest note are of no interest, the rest are pooled by
+        // their maximum until they fit, which keeps the peaks where they were
+        size_t wanted = qMin(bins, size_t(READING_RING_SPECTRUM_MAX_FREQ/binHz) + 1);
+        size_t stride = (wanted + layout.spectrumBins - 1)/layout.spectrumBins;
+        float* spectrum = (float*)(slot + 1);
+        size_t n = 0;
+        for (size_t k = 0; k < wanted; k += stride) {
+            size_t end = qMin(k + stride, wanted);
+            float p = power[k];
+            for (size_t j = k + 1; j < end; j++)
+                p = qMax(p, power[j]);
+            spectrum[n++] = p;
+        }
+        slot->spectrumBins = quint32(n);
+        slot->binHz = binHz*stride;
+    }
+    slot->sequence.fetchAndStoreRelease(int(2*frame + 2));
+}
+
+ReadingRingReader::ReadingRingReader() : mapping(NULL), mappingSize(0), header(NULL) {
+    memset(&layout, 0, sizeof(layout));
+}
+
+ReadingRingReader::~ReadingRingReader() {
+    close();
+}
+
+bool ReadingRingReader::open(const char* name) {
+    close();
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    void* m = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(ReadingRingHeader))
+        m = mmap(NULL, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED)
+        return false;
+    mapping = m;
+    mappingSize = size_t(st.st_size);
+
+    const ReadingRingHeader* h = (const ReadingRingHeader*)mapping;
+    if (memcmp(h->magic, READING_RING_MAGIC, sizeof(h->magic)) != 0 || h->version != READING_RING_VERSION ||
+            h->slotCount == 0 || h->slotSize < slotSize(h->spectrumBins) ||
+            ringSize(h->slotCount, h->slotSize) > mappingSize) {
+        qDebug("%s is not a reading ring", name);
+        close();
+        return false;
+    }
+    layout.slotCount = h->slotCount;
+    layout.slotSize = h->slotSize;
+    layout.spectrumBins = h->spectrumBins;
+    header = (ReadingRingHeader*)mapping;
+    return true;
+}
+
+void ReadingRingReader::close() {
+    if (mapping != NULL)
+        munmap(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+}
+
+bool ReadingRingReader::isAlive() const {
+    return header != NULL && header->alive.fetchAndAddAcquire(0) != 0;
+}
+
+quint32 ReadingRingReader::published() const {
+    return header != NULL ? quint32(header->claimed.fetchAndAddAcquire(0)) : 0;
+}
+
+ReadingRingSlot* ReadingRingReader::slot(quint32 frame) const {
+    return ringSlot(mapping, layout, frame);
+}
+
+bool ReadingRingReader::acquire(quint32 frame, ReadingRingView* view) const {
+    if (header == NULL)
+        return false;
+    ReadingRingSlot* s = slot(frame);
+    if (quint32(s->sequence.fetchAndAddAcquire(0)) != 2*frame + 2)
+        return false;
+    view->frame = frame;
+    view->note = &s->note;
+    view->spectrumBins = qMin(size_t(s->spectrumBins), layout.spectrumBins);
+    view->spectrum = view->spectrumBins > 0 ? (const float*)(s + 1) : NULL;
+    view->binHz = s->binHz;
+    return true;
+}
+
+bool ReadingRingReader::validate(const ReadingRingView& view) const {
+    // Ordered, so that none of the reads through the view can come after it
+    return header != NULL && quint32(slot(view.frame)->sequence.fetchAndAddOrdered(0)) == 2*view.frame + 2;
+}
+
+bool ReadingRingReader::read(quint32 frame, NoteInfo* note, float* spectrum, size_t maxBins, size_t* bins) const {
+    ReadingRingView view;
+    if (!acquire(frame, &view))
+        return false;
+    *note = *view.note;
+    size_t n = spectrum != NULL && view.spectrum != NULL ? qMin(maxBins, view.spectrumBins) : 0;
+    if (n > 0)
+        memcpy(spectrum, view.spectrum, n*sizeof(float));
+    if (!validate(view))
+        return false;
+    if (bins != NULL)
+        *bins = n;
+    return true;
+}
+
+bool ReadingRingReader::latest(ReadingRingView* view) const {
+    if (header == NULL)
+        return false;
+    // The newest frames may still be being written
+    quint32 newest = published();
+    for (quint32 back = 1; back <= layout.slotCount && back <= newest; back++) {
+        if (acquire(newest - back, view))
+            return true;
+    }
+    return false;
+}
+
+bool ReadingRingReader::next(quint32* cursor, ReadingRingView* view, quint32* missed) const {
+    if (header == NULL)
+        return false;
+    forever {
+        quint32 frame = *cursor;
+        quint32 newest = published();
+        if (qint32(newest - frame) <= 0)
+            return false;
+        if (newest - frame > layout.slotCount) {
+            // Overwritten already
+            if (missed != NULL)
+                *missed += newest - layout.slotCount - frame;
+            frame = newest - layout.slotCount;
+        }
+        if (acquire(frame, view)) {
+            *cursor = frame + 1;
+            return true;
+        }
+        // Either the frame is still being written, or a writer of the next lap has
+        // already got to its slot
+        quint32 sequence = quint32(slot(frame)->sequence.fetchAndAddAcquire(0));
+        if (qint32(sequence - (2*frame + 2)) < 0) {
+            *cursor = frame;
+            return false;
+        }
+        if (missed != NULL)
+            (*missed)++;
+        *cursor = frame + 1;
+    }
+}
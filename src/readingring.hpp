@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ReadingRing_HPP_
+#define ReadingRing_HPP_
+
+#include <QAtomicInt>
+#include <QtGlobal>
+#include <stddef.h>
+#include "noteinfo.hpp"
+
+#define READING_RING_MAGIC "TRNG"
+#define READING_RING_VERSION 1
+// Shared memory object readings are published in unless another is given
+#define READING_RING_DEFAULT_NAME "/tuner-readings"
+// Frames kept, a reader that falls further behind misses some
+#define READING_RING_SLOTS 64
+// Most spectrum bins published with a frame, and the frequency they reach up to. Finer
+// spectra are pooled down to that.
+#define READING_RING_DEFAULT_BINS 1024
+#define READING_RING_SPECTRUM_MAX_FREQ 5000.0f
+
+// The shared memory object starts with this header, followed by the slots. Everything
+// is in host byte order and layout, readers have to run on the same machine anyway.
+struct ReadingRingHeader {
+    char magic[4];
+    quint32 version;
+    quint32 slotCount;
+    // Bytes per slot, the spectrum included
+    quint32 slotSize;
+    // Most spectrum bins a slot holds, 0 if no spectra are published
+    quint32 spectrumBins;
+    quint32 sampleRate;
+    quint32 channels;
+    quint32 reserved;
+    // Frames claimed by writers so far, frame n goes into slot n % slotCount. Wraps around.
+    QAtomicInt claimed;
+    // Cleared when the publisher goes away, a new one creates a new object
+    QAtomicInt alive;
+};
+
+// Each slot starts with this, followed by up to spectrumBins floats
+struct ReadingRingSlot {
+    // Seqlock: 2*frame + 1 while frame is being written into the slot, 2*frame + 2
+    // once it is complete
+    QAtomicInt sequence;
+    quint32 spectrumBins;
+    // Frequency step of the spectrum, whose first bin is at 0 Hz
+    float binHz;
+    quint32 reserved;
+    NoteInfo note;
+};
+
+// Shape of a ring as its own process last checked it. The header is writable by every
+// reader, so the slots are only ever located through such a private copy.
+struct ReadingRingLayout {
+    size_t slotCount;
+    size_t slotSize;
+    size_t spectrumBins;
+};
+
+// A complete frame in place in the shared memory, see ReadingRingReader::acquire()
+struct ReadingRingView {
+    quint32 frame;
+    const NoteInfo* note;
+    // Power spectrum in the units of the float FFT of the raw samples, NULL if the frame
+    // has none, e.g. because it did not come from the FFT peak detector
+    const float* spectrum;
+    size_t spectrumBins;
+    float binHz;
+};
+
+/*
+ * Publishes readings, and optionally the power spectra they were made from, into a
+ * shared memory ring that any number of local processes can read with a
+ * ReadingRingReader, without locks and without the publisher ever waiting for them.
+ *
+ * Writers claim a frame number with one atomic add and fill in its slot under the
+ * slot's seqlock, so the analysis threads of all channels can publish concurrently.
+ * Slots are only reused after READING_RING_SLOTS further frames, long after the writer
+ * of the previous lap is done with them.
+ *
+ * The object is only accessible to the publisher's user, since readers need to map it
+ * writable. Readers running as that user can still scribble over it, which may spoil
+ * the readings but never makes the publisher write outside its mapping.
+ */
+class ReadingRingWriter {
+public:
+    ReadingRingWriter();
+    ~ReadingRingWriter();
+
+    // Creates the shared memory object name, replacing any left behind by a publisher
+    // that did not close it. Returns false if it cannot be created.
+    bool open(const char* name, int sampleRate, int channels, size_t spectrumBins = READING_RING_DEFAULT_BINS);
+    // Marks the ring as gone for its readers and removes the name
+    void close();
+    bool isOpen() const { return header != NULL; }
+
+    // Publishes a reading along with the bins bins of power, binHz apart, it came from.
+    // Safe to call from several threads at once.
+    void publish(const NoteInfo& note, const float* power = NULL, size_t bins = 0, float binHz = 0);
+
+private:
+    ReadingRingWriter(const ReadingRingWriter&);
+    ReadingRingWriter& operator=(const ReadingRingWriter&);
+
+    char name[64];
+    void* mapping;
+    size_t mappingSize;
+    ReadingRingHeader* header;
+    ReadingRingLayout layout;
+};
+
+/*
+ * Read side of a reading ring, for the processes consuming what the daemon publishes.
+ * Frames are looked at in place: acquire() hands out pointers into the shared memory
+ * and validate() tells afterwards whether the publisher overwrote the slot meanwhile,
+ * in which case whatever was read from it has to be thrown away. read() does both
+ * around a copy. Nothing is ever written except for the atomic loads, which Qt 4 only
+ * offers as read-modify-write operations, so the object is mapped writable.
+ *
+ * A reader belongs to a single thread, but any number of them can share a ring.
+ */
+class ReadingRingReader {
+public:
+    ReadingRingReader();
+    ~ReadingRingReader();
+
+    // Returns false if there is no ring of that name or it is not one
+    bool open(const char* name = READING_RING_DEFAULT_NAME);
+    void close();
+    bool isOpen() const { return header != NULL; }
+    // False once the publisher has closed the ring, reopen to follow a new one
+    bool isAlive() const;
+
+    int sampleRate() const { return header != NULL ? int(header->sampleRate) : 0; }
+    int channelCount() const { return header != NULL ? int(header->channels) : 0; }
+    size_t spectrumBins() const { return header != NULL ? layout.spectrumBins : 0; }
+
+    // Frame number the next published frame will get; the newest is one less
+    quint32 published() const;
+
+    // Points view at frame if it is complete and still in the ring
+    bool acquire(quint32 frame, ReadingRingView* view) const;
+    // Whether the frame of view is still intact, i.e. everything read through it is good
+    bool validate(const ReadingRingView& view) const;
+    // Copies frame, and its spectrum into up to maxBins floats. Returns the number of
+    // bins copied through bins.
+    bool read(quint32 frame, NoteInfo* note, float* spectrum = NULL, size_t maxBins = 0,
+            size_t* bins = NULL) const;
+
+    // The newest complete frame
+    bool latest(ReadingRingView* view) const;
+    // The frame at *cursor, and moves the cursor past it. Returns false if it has not
+    // been published yet. Frames the reader fell too far behind for are skipped and
+    // counted in *missed. A cursor set to published() follows the frames to come.
+    bool next(quint32* cursor, ReadingRingView* view, quint32* missed = NULL) const;
+
+private:
+    ReadingRingReader(const ReadingRingReader&);
+    ReadingRingReader& operator=(const ReadingRingReader&);
+
+    ReadingRingSlot* slot(quint32 frame) const;
+
+    void* mapping;
+    size_t mappingSize;
+    ReadingRingHeader* header;
+    ReadingRingLayout layout;
+};
+
+#endif /* ReadingRing_HPP_ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "recordingcapturebackend.hpp"
+
+#include <string.h>
+
+RecordingCaptureBackend::RecordingCaptureBackend(CaptureBackend* source, const char* path)
+    : source(source) {
+    strncpy(this->path, path, sizeof(this->path) - 1);
+    this->path[sizeof(this->path) - 1] = 0;
+}
+
+RecordingCaptureBackend::~RecordingCaptureBackend() {
+    close();
+    delete source;
+}
+
+bool RecordingCaptureBackend::open() {
+    if (!source->open())
+        return false;
+    // Capture goes on without the recording rather than not at all
+    if (writer.open(path, source->sampleRate(), source->channelCount(), source->fragmentSize()))
+        qDebug("Recording capture trace to %s", path);
+    return true;
+}
+
+void RecordingCaptureBackend::close() {
+    if (writer.isOpen() && !writer.close())
+        qDebug("Capture trace %s is incomplete", path);
+    source->close();
+}
+
+int RecordingCaptureBackend::capture(RingBuffer<short>* const* samples, int timeoutUs) {
+    int captured = source->capture(samples, timeoutUs);
+    if (captured > 0)
+        writer.recordFragment(samples, size_t(captured), monotonicMicros());
+    return captured;
+}
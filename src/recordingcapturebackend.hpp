@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef RecordingCaptureBackend_HPP_
+#define RecordingCaptureBackend_HPP_
+
+#include "capturebackend.hpp"
+#include "capturetrace.hpp"
+
+/*
+ * Passes another backend's capture through and records every fragment it delivers,
+ * with the time it arrived, into a capture trace. The readings made from them are added
+ * to the same trace through trace(), so that problems seen in the field can be replayed
+ * through the engine later, see TraceCaptureBackend.
+ */
+class RecordingCaptureBackend : public CaptureBackend {
+public:
+    // Takes ownership of source
+    RecordingCaptureBackend(CaptureBackend* source, const char* path);
+    virtual ~RecordingCaptureBackend();
+
+    virtual const char* name() const { return source->name(); }
+    virtual bool open();
+    virtual void close();
+    virtual bool pause() { return source->pause(); }
+    virtual bool resume() { return source->resume(); }
+    virtual int sampleRate() const { return source->sampleRate(); }
+    virtual int channelCount() const { return source->channelCount(); }
+    virtual size_t fragmentSize() const { return source->fragmentSize(); }
+    virtual int capture(RingBuffer<short>* const* samples, int timeoutUs);
+    virtual int overrunCount() const { return source->overrunCount(); }
+
+    CaptureTraceWriter* trace() { return &writer; }
+
+private:
+    RecordingCaptureBackend(const RecordingCaptureBackend&);
+    RecordingCaptureBackend& operator=(const RecordingCaptureBackend&);
+
+    CaptureBackend* source;
+    char path[256];
+    CaptureTraceWriter writer;
+};
+
+#endif /* RecordingCaptureBackend_HPP_ */
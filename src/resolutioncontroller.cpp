@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "resolutioncontroller.hpp"
+
+#include <math.h>
+
+ResolutionController::ResolutionController(int sampleRate, size_t minSize, size_t maxSize, float cents)
+    : sampleRate(sampleRate), minSize(minSize), maxSize(maxSize), precision(cents),
+      interpolationGain(RESOLUTION_INTERPOLATION_GAIN) {
+    reset();
+}
+
+void ResolutionController::reset() {
+    current = maxSize;
+    shrinkReadings = 0;
+    unstableReadings = 0;
+}
+
+float ResolutionController::requiredSize(float frequency) const {
+    // Resolving the frequency to the precision takes bins of interpolation gain times
+    // the smallest step that matters
+    float step = frequency*(powf(2.0f, precision/1200) - 1);
+    float forPrecision = sampleRate/(step*interpolationGain);
+    float forPeriods = RESOLUTION_MIN_PERIODS*sampleRate/frequency;
+    return forPrecision > forPeriods ? forPrecision : forPeriods;
+}
+
+size_t ResolutionController::roundedSize(float n) const {
+    size_t size = minSize;
+    while (size < maxSize && size < n)
+        size <<= 1;
+    return size;
+}
+
+size_t ResolutionController::unstable() {
+    shrinkReadings = 0;
+    if (++unstableReadings >= RESOLUTION_RESET_READINGS)
+        current = maxSize;
+    return current;
+}
+
+size_t ResolutionController::update(float frequency) {
+    unstableReadings = 0;
+
+    float needed = requiredSize(frequency);
+    if (roundedSize(needed) > current) {
+        current = roundedSize(needed);
+        shrinkReadings = 0;
+    } else if (roundedSize(needed*RESOLUTION_HYSTERESIS) < current) {
+        if (++shrinkReadings >= RESOLUTION_SHRINK_READINGS) {
+            current = roundedSize(needed*RESOLUTION_HYSTERESIS);
+            shrinkReadings = 0;
+        }
+    } else {
+        shrinkReadings = 0;
+    }
+    return current;
+}
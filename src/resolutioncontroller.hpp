@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ResolutionController_HPP_
+#define ResolutionController_HPP_
+
+#include <stddef.h>
+
+// Precision readings should have, in cents
+#define RESOLUTION_PRECISION_CENTS 1.0f
+// Interpolating between bins places a peak to about this fraction of a bin, unless the
+// peak estimator in use says otherwise
+#define RESOLUTION_INTERPOLATION_GAIN 10.0f
+// Periods of the fundamental a frame has to hold
+#define RESOLUTION_MIN_PERIODS 8.0f
+// A frame only shrinks to a size that leaves this much headroom over what is needed,
+// so a note hovering around a size boundary does not make the size flip back and forth
+#define RESOLUTION_HYSTERESIS 1.25f
+// Readings in a row that must allow a smaller frame before it shrinks
+#define RESOLUTION_SHRINK_READINGS 3
+// Unstable readings in a row after which the frame returns to its largest size, so that
+// a new low note can be resolved at all
+#define RESOLUTION_RESET_READINGS 15
+
+/*
+ * Picks the analysis frame size, a power of two, from the fundamental of the last stable
+ * reading. Low notes need long frames to be told apart to the required precision, high
+ * notes do with much shorter ones, which means less latency and less CPU. Growing
+ * happens at once, shrinking only when a smaller size has been enough for several
+ * readings and still leaves headroom.
+ */
+class ResolutionController {
+public:
+    ResolutionController(int sampleRate, size_t minSize, size_t maxSize,
+            float cents = RESOLUTION_PRECISION_CENTS);
+
+    void setPrecision(float cents) { precision = cents; }
+    float precisionCents() const { return precision; }
+    // See peakEstimatorGain()
+    void setInterpolationGain(float gain) { interpolationGain = gain; }
+
+    // Frame size in samples that resolves frequency to the precision, not rounded
+    float requiredSize(float frequency) const;
+
+    // Takes the fundamental of the latest stable reading and returns the frame size for
+    // the next one
+    size_t update(float frequency);
+    // Takes a reading that had a pitch which was not stable. Silence is not reported at
+    // all, it says nothing about the size the next note needs.
+    size_t unstable();
+    size_t size() const { return current; }
+    // Back to the largest size
+    void reset();
+
+private:
+    size_t roundedSize(float n) const;
+
+    int sampleRate;
+    size_t minSize;
+    size_t maxSize;
+    float precision;
+    float interpolationGain;
+
+    size_t current;
+    int shrinkReadings;
+    int unstableReadings;
+};
+
+#endif /* ResolutionController_HPP_ */
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RingBuffer_HPP_
+#define RingBuffer_HPP_
+
+#include <QAtomicInt>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Single-producer/single-consumer ring buffer. The producer appends with write() and
+ * never blocks: once the buffer is full the oldest samples are overwritten. The consumer
+ * looks at the newest samples in place through latest(), which returns them as at most
+ * two contiguous spans, oldest first.
+ *
+ * The capacity is rounded up to a power of two so that the free-running write position
+ * can be wrapped with a mask. Spans returned by latest() stay valid until the producer
+ * has written another (capacity - n) samples, so size the buffer with enough headroom
+ * for the consumer to finish with them.
+ */
+template <typename T>
+class RingBuffer {
+public:
+    struct Span {
+        const T* data;
+        size_t size;
+    };
+
+    explicit RingBuffer(size_t minCapacity) {
+        size_t capacity = 1;
+        while (capacity < minCapacity)
+            capacity <<= 1;
+        mask = capacity - 1;
+        data = new T[capacity];
+        memset(data, 0, capacity*sizeof(T));
+    }
+
+    ~RingBuffer() {
+        delete[] data;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Total number of samples written so far. Wraps around, use differences only.
+    unsigned int written() const {
+        return (unsigned int)writePos.fetchAndAddAcquire(0);
+    }
+
+    // Appends n samples. Producer side only.
+    void write(const T* src, size_t n) {
+        unsigned int head = (unsigned int)writePos.fetchAndAddRelaxed(0);
+
+        // Only the newest capacity() samples can survive the write
+        if (n > capacity()) {
+            head += n - capacity();
+            src += n - capacity();
+            n = capacity();
+        }
+
+        size_t start = head & mask;
+        size_t first = n < capacity() - start ? n : capacity() - start;
+        memcpy(&data[start], src, first*sizeof(T));
+        memcpy(&data[0], &src[first], (n - first)*sizeof(T));
+
+        writePos.fetchAndStoreRelease(int(head + n));
+    }
+
+    // Appends n samples taken from every stride-th element of src, e.g. one channel of
+    // interleaved frames. Producer side only.
+    void writeStrided(const T* src, size_t n, size_t stride) {
+        if (stride == 1) {
+            write(src, n);
+            return;
+        }
+        unsigned int head = (unsigned int)writePos.fetchAndAddRelaxed(0);
+
+        if (n > capacity()) {
+            head += n - capacity();
+            src += (n - capacity())*stride;
+            n = capacity();
+        }
+
+        for (size_t i = 0; i < n; i++)
+            data[(head + i) & mask] = src[i*stride];
+
+        writePos.fetchAndStoreRelease(int(head + n));
+    }
+
+    // Exposes the newest n samples (n <= capacity()) without copying them.
+    // Consumer side only.
+    void latest(size_t n, Span* first, Span* second) const {
+        before(written(), n, first, second);
+    }
+
+    // The same for the n samples that were the newest when written() was end. They
+    // have to be still there, i.e. written() - end + n <= capacity().
+    void before(unsigned int end, size_t n, Span* first, Span* second) const {
+        if (n > capacity())
+            n = capacity();
+
+        size_t start = (end - n) & mask;
+        size_t firstSize = n < capacity() - start ? n : capacity() - start;
+        first->data = &data[start];
+        first->size = firstSize;
+        second->data = &data[0];
+        second->size = n - firstSize;
+    }
+
+    // Copies the newest n samples into a contiguous destination. Consumer side only.
+    void copyLatest(T* dst, size_t n) const {
+        Span first, second;
+        latest(n, &first, &second);
+        memcpy(dst, first.data, first.size*sizeof(T));
+        memcpy(&dst[first.size], second.data, second.size*sizeof(T));
+    }
+
+private:
+    RingBuffer(const RingBuffer&);
+    RingBuffer& operator=(const RingBuffer&);
+
+    T* data;
+    size_t mask;
+    mutable QAtomicInt writePos;
+};
+
+#endif /* RingBuffer_HPP_ */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "silencegate.hpp"
+
+#include <math.h>
+
+SilenceGate::SilenceGate(int sampleRate) : sampleRate(sampleRate) {
+    floor = GATE_MIN_LEVEL;
+    open = false;
+    quietSamples = 0;
+    idleSamples = 0;
+    pitchlessSamples = 0;
+}
+
+float SilenceGate::level(const RingBuffer<short>* samples, size_t n) {
+    if (n == 0)
+        return 0;
+
+    RingBuffer<short>::Span spans[2];
+    samples->latest(n, &spans[0], &spans[1]);
+    float sum = 0;
+    for (int s = 0; s < 2; s++) {
+        for (size_t i = 0; i < spans[s].size; i++) {
+            float v = spans[s].data[i];
+            sum += v*v;
+        }
+    }
+    return sqrtf(sum/n);
+}
+
+void SilenceGate::reportPitch() {
+    pitchFound.fetchAndStoreRelease(1);
+}
+
+GateDecision SilenceGate::update(float level, size_t n) {
+    float seconds = float(n)/sampleRate;
+    if (level < floor)
+        floor = level < GATE_MIN_LEVEL ? GATE_MIN_LEVEL : level;
+
+    if (open) {
+        if (pitchFound.fetchAndStoreAcquire(0))
+            pitchlessSamples = 0;
+        else
+            pitchlessSamples += n;
+        // Loud, but nothing the analysis can make sense of: that is the background now
+        if (pitchlessSamples >= GATE_PITCHLESS_SECONDS*sampleRate)
+            floor = level;
+
+        if (level >= floor*GATE_CLOSE_RATIO) {
+            quietSamples = 0;
+            return GateOpen;
+        }
+        quietSamples += n;
+        if (quietSamples < GATE_HOLD_SECONDS*sampleRate)
+            return GateOpen;
+
+        open = false;
+        idleSamples = 0;
+        return GateClosed;
+    }
+
+    if (level >= floor*GATE_OPEN_RATIO && level >= GATE_MIN_LEVEL*GATE_OPEN_RATIO) {
+        open = true;
+        quietSamples = 0;
+        pitchlessSamples = 0;
+        pitchFound.fetchAndStoreRelaxed(0);
+        return GateOnset;
+    }
+
+    // Creep up towards a steady background, never above it
+    float risen = floor*powf(GATE_FLOOR_RISE, seconds);
+    floor = risen < level ? risen : level;
+
+    idleSamples += n;
+    if (level < GATE_MIN_LEVEL || idleSamples < sampleRate/GATE_IDLE_RATE)
+        return GateSilent;
+    idleSamples = 0;
+    return GateIdle;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SilenceGate_HPP_
+#define SilenceGate_HPP_
+
+#include <QAtomicInt>
+#include <stddef.h>
+#include "ringbuffer.hpp"
+
+// RMS below which a fragment is silence whatever the noise floor, in S16 units
+#define GATE_MIN_LEVEL 30.0f
+// Sound has to be this much above the noise floor to open the gate (6 dB)
+#define GATE_OPEN_RATIO 2.0f
+// and has to fall below this before the gate starts closing (3 dB)
+#define GATE_CLOSE_RATIO 1.4f
+// Time the level has to stay low before the gate closes, so that the decay of a note
+// and short gaps between notes keep it open
+#define GATE_HOLD_SECONDS 0.3f
+// Factor per second by which the noise floor rises towards a steady background
+#define GATE_FLOOR_RISE 2.0f
+// Analyses per second while the gate is closed but there is some sound, to catch
+// notes too soft to open it
+#define GATE_IDLE_RATE 2.0f
+// Time an open gate waits for the analysis to find a pitch before it takes the
+// current level as the noise floor. Long frames take a while to lock onto a new note.
+#define GATE_PITCHLESS_SECONDS 1.5f
+
+enum GateDecision {
+    // Closed, nothing to analyse
+    GateSilent,
+    // Closed with this fragment, the readings should go blank
+    GateClosed,
+    // Closed, but an idle analysis is due
+    GateIdle,
+    // Open, analyse at the normal hop
+    GateOpen,
+    // Opened with this fragment, analyse right away
+    GateOnset
+};
+
+/*
+ * Decides from the RMS of each incoming fragment whether spectral analysis is worth
+ * running at all. The gate opens when the level rises clearly above an adaptive noise
+ * floor, which reports an onset so the analysis can start without waiting for the next
+ * hop, and closes once the level has stayed near the floor for a while. While it is
+ * closed only a few idle analyses a second run, and none at all below GATE_MIN_LEVEL.
+ *
+ * The floor follows the level down at once and creeps up while the gate is closed. A
+ * steady noise loud enough to open the gate, like a fan, is learnt from the analysis:
+ * if no reading finds a pitch for GATE_PITCHLESS_SECONDS the current level becomes the
+ * floor. update() belongs to the capture thread, reportPitch() may be called from any.
+ */
+class SilenceGate {
+public:
+    explicit SilenceGate(int sampleRate);
+
+    // RMS of the newest n samples, in one pass
+    static float level(const RingBuffer<short>* samples, size_t n);
+
+    // Takes the level of the n samples that just arrived
+    GateDecision update(float level, size_t n);
+
+    bool isOpen() const { return open; }
+    float noiseFloor() const { return floor; }
+
+    // Tells the gate that a reading found a pitch
+    void reportPitch();
+
+private:
+    SilenceGate(const SilenceGate&);
+    SilenceGate& operator=(const SilenceGate&);
+
+    int sampleRate;
+    float floor;
+    bool open;
+    // Samples since the level was last high, since the last idle analysis and since
+    // the last reading with a pitch
+    size_t quietSamples;
+    size_t idleSamples;
+    size_t pitchlessSamples;
+
+    QAtomicInt pitchFound;
+};
+
+#endif /* SilenceGate_HPP_ */
@@ -20,303 +20,272 @@ SoundProcessor::SoundProcessor(QObject *parent) {
     setParent(parent);
     tuningFreq = 440;
     sampleRate = 44100;
-    card = -1;
-	init("pcmPreferred");
+    // All of these stay NULL if init() fails
+    backend = NULL;
+    trace = NULL;
+    publisher = NULL;
+    channels = 0;
+    samples = NULL;
+    analysers = NULL;
+    scheduler = NULL;
+    gate = NULL;
+    captureThread = NULL;
+    monitor = NULL;
+    statsTimer = NULL;
+    paused = false;
+    startedAt = 0;
+    startStage = ColdStartStage;
+
+    // TUNER_CAPTURE picks another capture source, e.g. a WAV file, a test tone or a
+    // capture trace, and TUNER_CHANNELS the number of channels to capture from it.
+    // TUNER_RECORD records a capture trace to the given path, TUNER_PUBLISH publishes
+    // the readings in the shared memory reading ring of the given name with
+    // TUNER_PUBLISH_BINS bins of spectrum, 0 for none. TUNER_FFT_SCALAR and
+    // TUNER_PEAK_ESTIMATOR override the arithmetic and the peak estimator of the FFT
+    // peak detector the build defaults to, and TUNER_DETECTOR the pitch detector to
+    // start with. TUNER_TARGET is the note to tune to, as parseNoteName() takes it,
+    // which starts with the strobe detector unless TUNER_DETECTOR picks another.
+    // TUNER_HOP_MS or TUNER_OVERLAP, in percent of the detector's frame, replace the
+    // default update rate.
+    const char* capture = getenv("TUNER_CAPTURE");
+    const char* channels = getenv("TUNER_CHANNELS");
+    const char* record = getenv("TUNER_RECORD");
+    const char* publish = getenv("TUNER_PUBLISH");
+    const char* bins = getenv("TUNER_PUBLISH_BINS");
+    const char* scalar = getenv("TUNER_FFT_SCALAR");
+    const char* estimator = getenv("TUNER_PEAK_ESTIMATOR");
+    const char* detector = getenv("TUNER_DETECTOR");
+    const char* target = getenv("TUNER_TARGET");
+    const char* hop = getenv("TUNER_HOP_MS");
+    const char* overlap = getenv("TUNER_OVERLAP");
+    fftScalar = FFT_DEFAULT_SCALAR;
+    if (scalar != NULL && !parseFftScalar(scalar, &fftScalar))
+        qDebug("Unknown FFT scalar type %s", scalar);
+    peakEstimator = PEAK_DEFAULT_ESTIMATOR;
+    if (estimator != NULL && !parsePeakEstimator(estimator, &peakEstimator))
+        qDebug("Unknown peak estimator %s", estimator);
+    publishBins = bins != NULL ? qMax(0, atoi(bins)) : READING_RING_DEFAULT_BINS;
+    hopMs = hop != NULL ? float(atof(hop)) : -1;
+    overlapPercent = overlap != NULL ? float(atof(overlap)) : -1;
+    init(capture != NULL ? capture : "pcmPreferred", channels != NULL ? atoi(channels) : 1, record, publish);
+    int note;
+    if (target != NULL && !parseNoteName(target, &note))
+        qDebug("Unknown target note %s", target);
+    else if (target != NULL)
+        setTargetNote(note);
+    PitchDetectorType type;
+    if (detector != NULL && !parsePitchDetector(detector, &type))
+        qDebug("Unknown pitch detector %s", detector);
+    else if (detector != NULL && isOpen())
+        setPitchDetector(type);
 }
 
 SoundProcessor::~SoundProcessor() {
 	terminate();
 }
 
-int SoundProcessor::init(const char * name) {
-	int rtn;
-	char *devName;
-
-	if (name == NULL) {
-		devName = (char*)"pcmPreferred";
-	} else {
-		devName = (char*)name;
-	}
-
-	if ((rtn = snd_pcm_open_name(&pcmHandle, devName, SND_PCM_OPEN_CAPTURE)) < 0) {
-		qDebug("snd_pcm_open_name failed: %s\n", snd_strerror(rtn));
+int SoundProcessor::init(const char * name, int channels, const char* recordPath, const char* publishName) {
+	startedAt = monotonicMicros();
+	startStage = ColdStartStage;
+	backend = createCaptureBackend(name, channels);
+	if (backend == NULL) {
+		qDebug("No capture backend for %s\n", name);
 		return FAILURE;
 	}
-
-	if ((rtn = snd_pcm_info(pcmHandle, &pcmInfo)) < 0) {
-		qDebug("snd_pcm_info failed: %s\n", snd_strerror(rtn));
-		return FAILURE;
+	if (recordPath != NULL) {
+		RecordingCaptureBackend* recorder = new RecordingCaptureBackend(backend, recordPath);
+		backend = recorder;
+		trace = recorder->trace();
 	}
-	card = pcmInfo.card;
-
-	memset(&pcmChannelInfo, 0, sizeof(pcmChannelInfo));
-	pcmChannelInfo.channel = SND_PCM_CHANNEL_CAPTURE;
-	if ((rtn = snd_pcm_plugin_info(pcmHandle, &pcmChannelInfo)) < 0) {
-		qDebug("snd_pcm_plugin_info failed: %s\n", snd_strerror(rtn));
-		return FAILURE;
-	}
-
-	memset(&pcmParams, 0, sizeof(pcmParams));
-
-	pcmParams.mode = SND_PCM_MODE_BLOCK;
-	pcmParams.channel = SND_PCM_CHANNEL_CAPTURE;
-	pcmParams.start_mode = SND_PCM_START_DATA;
-	pcmParams.stop_mode = SND_PCM_STOP_ROLLOVER;
-	pcmParams.buf.block.frag_size = pcmChannelInfo.max_fragment_size;
-
-	pcmParams.buf.block.frags_max = 0;
-	pcmParams.buf.block.frags_min = 1;
-
-	pcmParams.format.rate = sampleRate;
-	// other format options: SND_PCM_SFMT_S32_LE SND_PCM_FMT_U16_LE SND_PCM_SFMT_S24
-	pcmParams.format.format = SND_PCM_SFMT_S16_LE;
-	pcmParams.format.voices = 1;
-
-	if ((rtn = snd_pcm_plugin_params(pcmHandle, &pcmParams)) < 0) {
-		qDebug("snd_pcm_plugin_params failed: %s\n", snd_strerror(rtn));
-		return FAILURE;
-	}
-
-	fragSize = pcmParams.buf.block.frag_size;
-
-	if ((rtn = snd_pcm_channel_prepare(pcmHandle, SND_PCM_CHANNEL_CAPTURE)) < 0) {
-		qDebug("snd_pcm_channel_prepare failed: %s\n", snd_strerror(rtn));
+	if (!backend->open()) {
+		delete backend;
+		backend = NULL;
+		trace = NULL;
 		return FAILURE;
 	}
+	sampleRate = backend->sampleRate();
+	this->channels = backend->channelCount();
+	fragSize = int(backend->fragmentSize()*sizeof(short));
+	qDebug("Capturing %d channels through %s at %d Hz", this->channels, backend->name(), sampleRate);
 
 	// FFT related configuration
 	fftSize = 131072;
-	captureWindow = (size_t)ceil((float)fftSize/(float)fragSize)*fragSize;
-	fragBuff = new char[fragSize];
-	memset(fragBuff, 0, fragSize);
-	buff = new char[captureWindow];
-	memset(buff, 0, captureWindow);
-
-	historySize = 3;
-    history = new float[historySize];
-    memset(history, 0, sizeof(float)*historySize);
-
-    readCount = 0;
+	samples = new RingBuffer<short>*[this->channels];
+	analysers = new PitchAnalyser*[this->channels];
+	for (int c = 0; c < this->channels; c++) {
+		// Keep a fragment of headroom on top of the FFT window so that a reader
+		// of the newest fftSize samples is never overtaken by the next fragment
+		samples[c] = new RingBuffer<short>(fftSize + fragSize/sizeof(short));
+		analysers[c] = new PitchAnalyser(sampleRate, tuningFreq, fftSize, fftScalar);
+		analysers[c]->setPeakEstimator(peakEstimator);
+	}
+	scheduler = new AnalysisScheduler(sampleRate, analysers[0]->frameSize());
+	if (hopMs > 0)
+		scheduler->setHopMs(hopMs);
+	else if (overlapPercent >= 0)
+		scheduler->setOverlap(overlapPercent);
+	gate = new SilenceGate(sampleRate);
+	if (publishName != NULL) {
+		publisher = new ReadingRingWriter();
+		if (publisher->open(publishName, sampleRate, this->channels, publishBins)) {
+			qDebug("Publishing readings in %s", publishName);
+		} else {
+			delete publisher;
+			publisher = NULL;
+		}
+	}
 
     qDebug("Fragment size: %d", fragSize);
-    qDebug("Capture window size: %d", captureWindow);
-    qDebug("FFT size: %d", fftSize);
+    qDebug("Capture window size: %d", samples[0]->capacity());
+    qDebug("FFT size: %d (%s, %s)", fftSize, fftScalarName(fftScalar), peakEstimatorName(peakEstimator));
+    qDebug("Hop size: %d", scheduler->hopSize());
+
+	// Capture and analysis run on their own threads, readings are handed back to
+	// this thread through a queued connection. Channels are dealt out to at most one
+	// analysis thread per core.
+	monitor = new LatencyMonitor();
+	int threadCount = qMax(1, qMin(this->channels, QThread::idealThreadCount()));
+	for (int t = 0; t < threadCount; t++) {
+		QList<AnalysisChannel> assigned;
+		for (int c = t; c < this->channels; c += threadCount) {
+			AnalysisChannel channel = { c, analysers[c], samples[c] };
+			assigned.append(channel);
+		}
+		AnalysisThread* analysisThread = new AnalysisThread(assigned, scheduler, gate, monitor);
+		analysisThread->setPublisher(publisher);
+		connect(analysisThread, SIGNAL(readingAvailable()), this, SLOT(onReadingAvailable()), Qt::QueuedConnection);
+		analysisThreads.append(analysisThread);
+	}
+	captureThread = new CaptureThread(backend, samples, scheduler, analysisThreads, gate, monitor);
+	for (int t = 0; t < threadCount; t++)
+		analysisThreads[t]->start(QThread::HighPriority);
+	captureThread->start(QThread::TimeCriticalPriority);
 
-	// connect fd listener
-	int pcmfd = snd_pcm_file_descriptor(pcmHandle, SND_PCM_CHANNEL_CAPTURE);
-	fdNotifier = new QSocketNotifier(pcmfd, QSocketNotifier::Read);
-	connect(fdNotifier, SIGNAL(activated(int)), this, SLOT(readPCM()));
+	statsTimer = new QTimer(this);
+	connect(statsTimer, SIGNAL(timeout()), this, SLOT(onStatsTimeout()));
+	statsTimer->start(STATS_DUMP_INTERVAL_MS);
 
 	return SUCCESS;
 }
 
-void SoundProcessor::readPCM() {
-    ssize_t bytesRead = snd_pcm_read(pcmHandle, fragBuff, fragSize);
-    //qDebug("Bytes read: %d", bytesRead);
-
-    // Add read bytes to the end of the buffer, remove old data from the beginning of
-    // the buffer.
-    // TODO: replace with ring buffer
-    if (bytesRead > 0) {
-        char* tmp = new char[captureWindow-bytesRead];
-        memcpy(&tmp[0], &buff[bytesRead], captureWindow-bytesRead);
-        memcpy(&buff[0], &tmp[0], captureWindow - bytesRead);
-        memcpy(&buff[captureWindow-bytesRead], fragBuff, bytesRead);
-        readCount++;
-        delete tmp;
-    }
-
-    // Don't analyse every single reading
-    if (readCount == 2) {
-        NoteInfo note = getNote();
-        emit readingUpdated(note);
-
-        readCount = 0;
-    }
-}
-
-SoundProcessor::NoteInfo SoundProcessor::getNote() {
-    struct NoteInfo note;
-    note.note[0] = 0;
-    note.centsDiff = 0.0f;
-
-    kiss_fft_scalar *fftIn = new kiss_fft_scalar[fftSize];
-    kiss_fft_cpx *fftOut = new kiss_fft_cpx[fftSize*2];
-    kiss_fftr_cfg fft = kiss_fftr_alloc(fftSize, 0, 0, 0);
-    memcpy(fftIn, buff, fftSize);
-    struct timespec t0, t1;
-    clock_gettime(CLOCK_REALTIME, &t0);
-
-    size_t windowSize = fftSize;
-    applyWindow(fftIn, windowSize);
-    kiss_fftr(fft, fftIn, fftOut);
-
-    clock_gettime(CLOCK_REALTIME, &t1);
-    qDebug("FFT took %li sec + %f msec\n", long(t1.tv_sec) - long(t0.tv_sec), float(long(t1.tv_nsec) - long(t0.tv_nsec))/1000000);
-    float maxAmplitude = 0;
-    int bin = 0;
-    for (size_t j=0; j < fftSize; j++) {
-        float amplitude = getAmplitude(fftOut[j]);
-        if (amplitude > maxAmplitude) {
-            maxAmplitude = amplitude;
-            bin = j;
-        }
-    }
-
-    if (maxAmplitude > 40) {
-        float freq = convertBinToFreq(bin);
-        float adjustedFreq = freq;
-        float adjustedAmplitude = maxAmplitude;
-        int overtone = 1;
-        silentReadCount = 0;
-
-        // For small FFT sizes interpolation is required, the dominant bin's and adjacent bins'
-        // amplitudes fluctuates as the actual frequency changes
-        if (bin > 0 && fftSize <= 32768) {
-            float freqL = convertBinToFreq(bin-1);
-            float freqR = convertBinToFreq(bin+1);
-            float amplitudeL = getAmplitude(fftOut[bin-1]);
-            float amplitudeR = getAmplitude(fftOut[bin+1]);
-
-            // Linear interpolation crudely approximates the frequency from two adjacent bins
-            //adjustedFreq = freq + (freqR - freq)*(amplitudeR/maxAmplitude) + (freqL - freq)*(amplitudeL/maxAmplitude);
-
-            // Approximate the frequency based on two adjacent bins using a quadratic curve
-            getParabolicInterpolationVertex(freqL, amplitudeL, freq, maxAmplitude, freqR, amplitudeR, &adjustedFreq, &adjustedAmplitude);
-        }
-
-        // Detect if we caught an overtone instead of the fundamental
-        //overtone = getOvertone(fftOut, adjustedFreq, bin);
-
-        // Push older values in history of captured frequencies back in the history array
-        for (size_t h = 1; h < historySize; h++)
-            history[h-1] = history[h];
-        history[historySize - 1] = adjustedFreq;
-
-        bool consistentTone = true;
-        bool saneFreqRange = freq >= 20 && freq <= 22000;
-        for (size_t h = 1; h < historySize; h++) {
-            float freq = history[h];
-            float prevFreq = history[h-1];
-            if (freq > prevFreq*1.1 || freq < prevFreq*0.9) {
-                consistentTone = false;
-                break;
+void SoundProcessor::onReadingAvailable() {
+    NoteInfo note;
+    for (int t = 0; t < analysisThreads.size(); t++) {
+        for (int i = 0; i < analysisThreads[t]->channelCount(); i++) {
+            if (analysisThreads[t]->takeReading(i, &note)) {
+                // Readings that were under way when capture paused don't count
+                if (startedAt != 0 && note.timing.captured >= startedAt) {
+                    qint64 now = monotonicMicros();
+                    monitor->record(startStage, startedAt, now);
+                    qDebug("First reading %.1f ms after %s", (now - startedAt)/1000.0f,
+                            startStage == ResumeStage ? "resuming" : "starting");
+                    startedAt = 0;
+                }
+                if (trace != NULL)
+                    trace->recordReading(note, monotonicMicros());
+                emit readingUpdated(note);
             }
         }
-
-        // Sanity check to filter out unstable readings. If reading is not stable, return an empty note
-        if (consistentTone && saneFreqRange) {
-            //convertFreqToNote(freq, maxAmplitude, overtone, &lastStableNote);
-            convertFreqToNote(adjustedFreq, maxAmplitude, overtone, &note);
-            qDebug("f=%f a=%f %s", freq, maxAmplitude, note.note);
-        } else {
-            note.note[0] = 0;
-            note.centsDiff = 0.0f;
-        }
-    } else {
-        // Maximum signal amplitude is too low
-        silentReadCount++;
     }
-
-    // cleanup
-    kiss_fft_free(fft);
-    delete fftIn;
-    delete fftOut;
-
-    return note;
 }
 
-int SoundProcessor::terminate() {
-    disconnect(fdNotifier, SIGNAL(activated(int)), this, SLOT(readPCM()));
-    delete fdNotifier;
-
-	int rtn;
-	if ((rtn = snd_pcm_close(pcmHandle)) < 0) {
-		qDebug("snd_pcm_close failed: %s\n", snd_strerror(rtn));
-		return FAILURE;
-	}
-	delete buff;
-	delete fragBuff;
-	delete history;
+void SoundProcessor::onStatsTimeout() {
+    monitor->dump();
+}
 
-	return SUCCESS;
+void SoundProcessor::pause() {
+    if (backend == NULL || paused)
+        return;
+    // The analysis threads simply run out of requests
+    captureThread->pause();
+    statsTimer->stop();
+    monitor->dump();
+    startedAt = 0;
+    paused = true;
 }
 
-void SoundProcessor::applyWindow(float* data, int n) {
-	for (int i = 0; i < n; i++) {
-		float coef = 0.5*(1 - cos(2*F_PI*i/(n-1)));
-		data[i] = short(coef*float(data[i]));
-	}
+void SoundProcessor::resume() {
+    if (backend == NULL || !paused)
+        return;
+    startedAt = monotonicMicros();
+    startStage = ResumeStage;
+    captureThread->resume();
+    statsTimer->start(STATS_DUMP_INTERVAL_MS);
+    paused = false;
 }
 
-void SoundProcessor::convertFreqToNote(float f, float a, int overtone, struct NoteInfo* description) {
-	const char* noteNames[] = { "A", "A#", "B", "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#" };
-	float linearF = log2((f/overtone)/tuningFreq) + 4;
-	float octave = floor(linearF);
-	float centsTotal = 1200*(linearF - octave);
-	int noteNumber = int(floor(centsTotal/100)) % 12;
-	float centsOff = centsTotal - noteNumber*100;
-	if (centsOff > 50) {
-		noteNumber++;
-		if (noteNumber >= 12) {
-			noteNumber = noteNumber % 12;
-			octave++;
-		}
-		centsTotal = 1200*(linearF - octave);
-		centsOff = centsTotal - noteNumber*100;
-	}
-	sprintf(description->note, "%s%d", noteNames[noteNumber], int(octave));
-	description->centsDiff = centsOff;
-	description->frequency = f;
-	description->amplitude = a;
+void SoundProcessor::setPitchDetector(PitchDetectorType type) {
+    if (backend == NULL)
+        return;
+    for (int c = 0; c < channels; c++)
+        analysers[c]->setDetector(type);
+    // Overlap is relative to the frame, which depends on the detector
+    scheduler->setFrameSize(analysers[0]->frameSize());
 }
 
-inline float SoundProcessor::getAmplitude(kiss_fft_cpx cpx) {
-	return sqrt(pow(cpx.r, 2) + pow(cpx.i, 2));
+void SoundProcessor::setTargetNote(int note) {
+    if (backend == NULL)
+        return;
+    for (int c = 0; c < channels; c++)
+        analysers[c]->setTargetNote(note);
+    setPitchDetector(StrobePitchDetector);
 }
 
-inline float SoundProcessor::convertBinToFreq(int bin) {
-	return ((bin-1)*(sampleRate/2))/(fftSize/2);
+const RingBuffer<PitchTrackPoint>* SoundProcessor::pitchTrack(int channel) const {
+    if (backend == NULL || channel < 0 || channel >= channels)
+        return NULL;
+    return analysers[channel]->pitchTrack();
 }
 
-inline int SoundProcessor::convertFreqToBin(float f) {
-	return int(floor(f*(fftSize/2)/(sampleRate/2))) + 2;
+size_t SoundProcessor::pitchTrackHop() const {
+    return backend != NULL ? analysers[0]->pitchTrackHop() : PHASE_VOCODER_HOP;
 }
 
-void SoundProcessor::getParabolicInterpolationVertex(float x1, float y1, float x2, float y2, float x3, float y3, float* xv, float* yv) {
-	double d = (x1 - x2) * (x1 - x3) * (x2 - x3);
-	double a = (x3 * (y2 - y1) + x2 * (y1 - y3) + x1 * (y3 - y2)) / d;
-	double b = (x3*x3 * (y1 - y2) + x2*x2 * (y3 - y1) + x1*x1 * (y2 - y3)) / d;
-	double c = (x2 * x3 * (x2 - x3) * y1 + x3 * x1 * (x3 - x1) * y2 + x1 * x2 * (x1 - x2) * y3) / d;
+int SoundProcessor::overrunCount() const {
+    return captureThread != NULL ? captureThread->overrunCount() : 0;
+}
 
-	*xv = b*(-1) / (2*a);
-	*yv = c - b*b / (4*a);
+int SoundProcessor::droppedFrameCount() const {
+    int dropped = 0;
+    for (int t = 0; t < analysisThreads.size(); t++)
+        dropped += analysisThreads[t]->droppedFrameCount() + analysisThreads[t]->droppedReadingCount();
+    return dropped;
 }
 
-float SoundProcessor::getOvertone(kiss_fft_cpx *fft, float freq, int bin) {
-    float overtone = 1;
-    if (bin > 1) {
-        // check if the bin caught an overtone
-        float fundamentalAmplitude = 0.0f;
-        for (float m = 1.5; m <= 2.0; m += 0.5) {
-            float a = 0;
-            int binGuess = convertFreqToBin(freq/m);
-            //int b = binGuess;
-            for (int b = binGuess -1; (b <= binGuess + 1) && (b > 0); b++) {
-                a = getAmplitude(fft[b]);
-                if (a > fundamentalAmplitude) {
-                    fundamentalAmplitude = a;
-                    overtone = m;
-                }
-            }
-            //qDebug("f/%f amplitude=%f\n", m, a);
-        }
-        if (fundamentalAmplitude >= freq*0.5) {
-            qDebug("Overtone detected: f*%f, a=%f\n", overtone, fundamentalAmplitude);
-        } else {
-            overtone = 1;
-        }
-    }
+int SoundProcessor::terminate() {
+    // Nothing was started if init() failed
+    if (backend == NULL)
+        return FAILURE;
+
+    // Stop capturing before the analysis worker, the capture thread may still request
+    // an analysis until it has stopped
+    statsTimer->stop();
+    captureThread->stop();
+    for (int t = 0; t < analysisThreads.size(); t++)
+        analysisThreads[t]->stop();
+    monitor->dump();
+    delete statsTimer;
+    delete captureThread;
+    qDeleteAll(analysisThreads);
+    analysisThreads.clear();
+    delete monitor;
+
+	backend->close();
+	delete backend;
+	backend = NULL;
+	trace = NULL;
+	// Only now that no analysis thread can publish any more
+	delete publisher;
+	publisher = NULL;
+	for (int c = 0; c < channels; c++) {
+		delete analysers[c];
+		delete samples[c];
+	}
+	delete[] analysers;
+	delete[] samples;
+	delete scheduler;
+	delete gate;
 
-    return overtone;
+	return SUCCESS;
 }
+
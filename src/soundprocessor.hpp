@@ -17,7 +17,8 @@
 #ifndef SoundProcessor_HPP_
 #define SoundProcessor_HPP_
 
-#include <bb/cascades/Application>
+#include <QObject>
+#include <QTimer>
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
@@ -30,75 +31,115 @@
 #include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <sys/asoundlib.h>
-#include "kiss_fft.h"
-#include "kiss_fftr.h"
+#include "analysisscheduler.hpp"
+#include "analysisthread.hpp"
+#include "capturebackend.hpp"
+#include "capturethread.hpp"
+#include "latencymonitor.hpp"
+#include "noteinfo.hpp"
+#include "pitchanalyser.hpp"
+#include "readingring.hpp"
+#include "recordingcapturebackend.hpp"
+#include "ringbuffer.hpp"
+#include "silencegate.hpp"
 
 #define SUCCESS 0
 #define FAILURE -1
 #define F_PI 3.14159265f
-
-#define DETECT_OVERTONES
+// How often the pipeline statistics are logged
+#define STATS_DUMP_INTERVAL_MS 10000
 
 class SoundProcessor : public QObject {
     Q_OBJECT
 
 public:
-    struct NoteInfo {
-    	char note[16];
-    	float centsDiff;
-    	float amplitude;
-    	float frequency;
-    };
+    typedef ::NoteInfo NoteInfo;
 
     SoundProcessor(QObject *parent = 0);
     virtual ~SoundProcessor();
 
-    int init(const char*);
+    // Capture source as understood by createCaptureBackend(), and the number of
+    // channels to capture and analyse separately. With a recordPath the capture and the
+    // readings are recorded into a capture trace there, with a publishName they are
+    // published to other processes through the ReadingRingWriter of that name.
+    int init(const char*, int channels = 1, const char* recordPath = NULL,
+            const char* publishName = NULL);
     int terminate();
+    // Whether init() succeeded, and whether it got the reading ring it was asked for
+    bool isOpen() const { return backend != NULL; }
+    bool isPublishing() const { return publisher != NULL; }
+
+    // Stops capturing and analysing but keeps the device open and the buffers, plans and
+    // note history as they are, so that resume() carries on within a fragment or two
+    // instead of starting cold
+    void pause();
+    void resume();
+    bool isPaused() const { return paused; }
+
+    AnalysisScheduler* analysisScheduler() { return scheduler; }
+
+    void setPitchDetector(PitchDetectorType type);
+    // Switches to the strobe detector listening for the given MIDI note, see also
+    // TUNER_TARGET
+    void setTargetNote(int note);
+
+    // Channels actually captured, each of them gets its own readings
+    int channelCount() const { return channels; }
+    int sampleRateHz() const { return sampleRate; }
+
+    // High rate pitch track of a channel, filled while the phase vocoder detector is
+    // in use, see PitchAnalyser::pitchTrack(). NULL if there is no such channel.
+    const RingBuffer<PitchTrackPoint>* pitchTrack(int channel) const;
+    size_t pitchTrackHop() const;
+
+    int overrunCount() const;
+    int droppedFrameCount() const;
+
+    // Latencies and counters of the running pipeline. The UI records through it when
+    // it has shown a reading. NULL unless open.
+    LatencyMonitor* latencyMonitor() { return monitor; }
 
 Q_SIGNALS:
+    // Emitted for every channel, see NoteInfo::channel
     void readingUpdated(SoundProcessor::NoteInfo);
 
-public Q_SLOTS:
-    void readPCM();
-
-private:
-    NoteInfo getNote();
-    void applyWindow(float*, int);
-    void convertFreqToNote(float, float, int, struct NoteInfo*);
-    inline float getAmplitude(kiss_fft_cpx);
-    inline float convertBinToFreq(int);
-    inline int convertFreqToBin(float);
-    void getParabolicInterpolationVertex(float, float, float, float, float, float, float*, float*);
-    float getOvertone(kiss_fft_cpx*, float, int);
+private Q_SLOTS:
+    void onReadingAvailable();
+    void onStatsTimeout();
 
 private:
-    int card;
-    QSocketNotifier* fdNotifier;
-    char* fragBuff;
-    char* buff;
-    float* history;
-    size_t historySize;
-    int readCount;
-    int silentReadCount;
-    snd_pcm_t* pcmHandle;
-    snd_pcm_info_t pcmInfo;
-    snd_pcm_format_t pcmFormat;
-    snd_pcm_channel_params_t pcmParams;
-    snd_pcm_channel_setup_t pcmSetup;
-    snd_pcm_channel_info_t pcmChannelInfo;
-
-    snd_mixer_t* mixerHandle;
-    snd_mixer_group_t group;
+    CaptureBackend* backend;
+    // NULL unless recording
+    CaptureTraceWriter* trace;
+    // NULL unless publishing, with this many spectrum bins
+    ReadingRingWriter* publisher;
+    int publishBins;
+    int channels;
+    // Per channel
+    RingBuffer<short>** samples;
+    PitchAnalyser** analysers;
+    AnalysisScheduler* scheduler;
+    // Hop the scheduler starts with, either of them, none if both are negative
+    float hopMs;
+    float overlapPercent;
+    SilenceGate* gate;
+    CaptureThread* captureThread;
+    QList<AnalysisThread*> analysisThreads;
+    LatencyMonitor* monitor;
+    QTimer* statsTimer;
+    bool paused;
+    // When capture was started or resumed, until the first reading since. Recorded as
+    // startStage.
+    qint64 startedAt;
+    LatencyStage startStage;
 
     int tuningFreq;
     int sampleRate;
-    int sampleChannels;
+    FftScalarType fftScalar;
+    PeakEstimator peakEstimator;
     int sampleBits;
     int fragSize;
 
-    size_t captureWindow;
     size_t fftSize;
     size_t sampleReplications;
 };
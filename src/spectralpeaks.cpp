@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "spectralpeaks.hpp"
+
+#include <math.h>
+#include <string.h>
+#include "fftplancache.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void powerSpectrum(const kiss_fft_cpx* in, float* out, size_t n) {
+    size_t k = 0;
+#if defined(__SSE2__)
+    const float* data = (const float*)in;
+    for (; k + 4 <= n; k += 4) {
+        __m128 a = _mm_loadu_ps(&data[2*k]);
+        __m128 b = _mm_loadu_ps(&data[2*k + 4]);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(&out[k], _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float* data = (const float*)in;
+    for (; k + 4 <= n; k += 4) {
+        float32x4x2_t c = vld2q_f32(&data[2*k]);
+        vst1q_f32(&out[k], vmlaq_f32(vmulq_f32(c.val[0], c.val[0]), c.val[1], c.val[1]));
+    }
+#endif
+    for (; k < n; k++)
+        out[k] = in[k].r*in[k].r + in[k].i*in[k].i;
+}
+
+void powerSpectrum(const FixedComplex<qint16>* in, float* out, size_t n, float gain) {
+    size_t k = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const qint16* data = (const qint16*)in;
+    float32x4_t g = vdupq_n_f32(gain);
+    for (; k + 4 <= n; k += 4) {
+        int16x4x2_t c = vld2_s16(&data[2*k]);
+        // Each square fits 31 bits, their sum only unsigned
+        uint32x4_t re = vreinterpretq_u32_s32(vmull_s16(c.val[0], c.val[0]));
+        uint32x4_t im = vreinterpretq_u32_s32(vmull_s16(c.val[1], c.val[1]));
+        vst1q_f32(&out[k], vmulq_f32(vcvtq_f32_u32(vaddq_u32(re, im)), g));
+    }
+#endif
+    for (; k < n; k++)
+        out[k] = gain*(float(in[k].r)*in[k].r + float(in[k].i)*in[k].i);
+}
+
+void powerSpectrum(const FixedComplex<qint32>* in, float* out, size_t n, float gain) {
+    for (size_t k = 0; k < n; k++)
+        out[k] = gain*(float(in[k].r)*float(in[k].r) + float(in[k].i)*float(in[k].i));
+}
+
+// Power in the units of the float FFT, whatever the scalar type of the spectrum
+static inline void blockPower(const kiss_fft_cpx* in, float* out, size_t n, float) {
+    powerSpectrum(in, out, n);
+}
+
+template <typename T>
+static inline void blockPower(const FixedComplex<T>* in, float* out, size_t n, float gain) {
+    powerSpectrum(in, out, n, gain);
+}
+
+// True if any of the four values starting at p is above threshold
+static inline bool anyAbove(const float* p, float threshold) {
+#if defined(__SSE2__)
+    return _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(p), _mm_set1_ps(threshold))) != 0;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    uint32x4_t above = vcgtq_f32(vld1q_f32(p), vdupq_n_f32(threshold));
+    uint32x2_t folded = vorr_u32(vget_low_u32(above), vget_high_u32(above));
+    return (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) != 0;
+#else
+    return p[0] > threshold || p[1] > threshold || p[2] > threshold || p[3] > threshold;
+#endif
+}
+
+SpectralPeakPicker::SpectralPeakPicker(size_t bins) : bins(bins) {
+    powerBuff = (float*)allocAligned(sizeof(float)*bins);
+    memset(powerBuff, 0, sizeof(float)*bins);
+}
+
+SpectralPeakPicker::~SpectralPeakPicker() {
+    freeAligned(powerBuff);
+}
+
+template <typename Complex>
+size_t SpectralPeakPicker::find(const Complex* spectrum, size_t firstBin, size_t lastBin,
+        SpectralPeak* peaks, size_t maxPeaks, float minPower, float gain) {
+    // Every candidate needs a neighbour on both sides
+    if (firstBin < 1)
+        firstBin = 1;
+    if (lastBin > bins - 1)
+        lastBin = bins - 1;
+    if (firstBin >= lastBin || maxPeaks == 0)
+        return 0;
+
+    size_t count = 0;
+    float threshold = minPower;
+
+    blockPower(&spectrum[firstBin - 1], &powerBuff[firstBin - 1], 1, gain);
+    for (size_t start = firstBin; start < lastBin; start += SPECTRAL_PEAK_BLOCK) {
+        size_t end = start + SPECTRAL_PEAK_BLOCK;
+        if (end > lastBin)
+            end = lastBin;
+        // One bin ahead so the last candidate of the block has its right neighbour
+        blockPower(&spectrum[start], &powerBuff[start], end + 1 - start, gain);
+
+        size_t k = start;
+        while (k < end) {
+            if (k + 4 <= end && !anyAbove(&powerBuff[k], threshold)) {
+                k += 4;
+                continue;
+            }
+            float p = powerBuff[k];
+            if (p > threshold && p > powerBuff[k-1] && p >= powerBuff[k+1]) {
+                // Insert into the peaks found so far, kept sorted strongest first
+                size_t i = count < maxPeaks ? count++ : maxPeaks - 1;
+                while (i > 0 && peaks[i-1].power < p) {
+                    peaks[i] = peaks[i-1];
+                    i--;
+                }
+                peaks[i].bin = k;
+                peaks[i].power = p;
+                peaks[i].powerL = powerBuff[k-1];
+                peaks[i].powerR = powerBuff[k+1];
+                if (count == maxPeaks)
+                    threshold = peaks[maxPeaks - 1].power;
+            }
+            k++;
+        }
+    }
+
+    return count;
+}
+
+template size_t SpectralPeakPicker::find(const kiss_fft_cpx*, size_t, size_t, SpectralPeak*, size_t, float, float);
+template size_t SpectralPeakPicker::find(const FixedComplex<qint16>*, size_t, size_t, SpectralPeak*, size_t, float, float);
+template size_t SpectralPeakPicker::find(const FixedComplex<qint32>*, size_t, size_t, SpectralPeak*, size_t, float, float);
+
+float logParabolicOffset(float powerL, float power, float powerR) {
+    float la = log(powerL + 1e-20f);
+    float lb = log(power + 1e-20f);
+    float lc = log(powerR + 1e-20f);
+    float denominator = la - 2*lb + lc;
+    if (denominator >= 0)
+        return 0;
+    return 0.5f*(la - lc)/denominator;
+}
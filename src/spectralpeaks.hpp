@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SpectralPeaks_HPP_
+#define SpectralPeaks_HPP_
+
+#include <stddef.h>
+#include "fixedfft.hpp"
+#include "kiss_fft.h"
+
+// Bins whose power is computed and scanned in one go, small enough to stay in L1
+#define SPECTRAL_PEAK_BLOCK 512
+
+// A local maximum of the power spectrum with its neighbours, for interpolation
+struct SpectralPeak {
+    size_t bin;
+    float power;
+    float powerL;
+    float powerR;
+};
+
+/*
+ * Finds the strongest local maxima of a power spectrum. Squared magnitudes are computed
+ * block by block into a buffer owned by the picker and each block is scanned while it
+ * is still in cache; groups of bins that cannot beat the weakest peak kept so far are
+ * skipped with a single vector compare. The power spectrum stays available afterwards
+ * for anything else that needs it, e.g. the harmonic analysis. A picker belongs to a
+ * single thread.
+ *
+ * Spectra of the fixed point FFT are scaled down, the gain given to find() brings their
+ * power back to the units of the float FFT so that thresholds mean the same for both.
+ */
+class SpectralPeakPicker {
+public:
+    explicit SpectralPeakPicker(size_t bins);
+    ~SpectralPeakPicker();
+
+    // Looks at bins [firstBin, lastBin) of spectrum and stores up to maxPeaks peaks
+    // stronger than minPower in peaks, strongest first. Returns the number found.
+    // Instantiated for kiss_fft_cpx and the FixedComplex types.
+    template <typename Complex>
+    size_t find(const Complex* spectrum, size_t firstBin, size_t lastBin,
+            SpectralPeak* peaks, size_t maxPeaks, float minPower = 0, float gain = 1);
+
+    // Power of the bins the last find() looked at, plus one either side
+    const float* power() const { return powerBuff; }
+
+private:
+    SpectralPeakPicker(const SpectralPeakPicker&);
+    SpectralPeakPicker& operator=(const SpectralPeakPicker&);
+
+    size_t bins;
+    float* powerBuff;
+};
+
+// Squared magnitudes of n complex bins: out[k] = re^2 + im^2
+void powerSpectrum(const kiss_fft_cpx* in, float* out, size_t n);
+// The same for fixed point bins, times gain: out[k] = gain*(re^2 + im^2)
+void powerSpectrum(const FixedComplex<qint16>* in, float* out, size_t n, float gain);
+void powerSpectrum(const FixedComplex<qint32>* in, float* out, size_t n, float gain);
+
+// Vertex of the parabola through the log powers of a peak and its neighbours, as an
+// offset in bins from the peak
+float logParabolicOffset(float powerL, float power, float powerR);
+
+#endif /* SpectralPeaks_HPP_ */
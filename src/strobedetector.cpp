@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "strobedetector.hpp"
+
+#include <math.h>
+
+StrobeDetector::StrobeDetector(int sampleRate) : sampleRate(sampleRate) {
+    setTarget(440);
+}
+
+StrobeDetector::~StrobeDetector() {
+}
+
+void StrobeDetector::setTarget(float frequency) {
+    targetFreq = frequency;
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        for (int o = 0; o < STROBE_OFFSETS; o++) {
+            int k = h*STROBE_OFFSETS + o;
+            double cents = o*STROBE_STEP_CENTS - STROBE_SPAN_CENTS;
+            double f = (h + 1)*frequency*pow(2.0, cents/1200);
+            omega[k] = 2*M_PI*f/sampleRate;
+
+            // Bandwidth of roughly one filter spacing, so neighbouring filters overlap
+            // without blurring the bank
+            double bandwidth = f*(pow(2.0, STROBE_STEP_CENTS/1200.0) - 1);
+            double timeConstant = sampleRate/(2*M_PI*bandwidth);
+            decay[k] = float(1 - 1/timeConstant);
+            // A sine of amplitude A settles at |state| = A/(2*(1 - decay))
+            gain[k] = 2*(1 - decay[k]);
+        }
+    }
+    signalDecay = decay[STROBE_OFFSETS/2];
+    reset();
+}
+
+void StrobeDetector::reset() {
+    for (int k = 0; k < STROBE_FILTERS; k++) {
+        stateR[k] = 0;
+        stateI[k] = 0;
+        phase[k] = 0;
+    }
+    signalPower = 0;
+    primed = false;
+    lastFilter = -1;
+    sampleIndex = 0;
+    lastPhaseIndex = 0;
+    lastDetected = false;
+}
+
+void StrobeDetector::process(const short* data, size_t n) {
+    for (int k = 0; k < STROBE_FILTERS; k++) {
+        // Start from the exact reference phase so rounding errors of the per-sample
+        // rotation never accumulate across calls
+        double start = fmod(omega[k]*sampleIndex, 2*M_PI);
+        float pR = cos(start);
+        float pI = -sin(start);
+        float rotR = cos(omega[k]);
+        float rotI = -sin(omega[k]);
+        float sR = stateR[k];
+        float sI = stateI[k];
+        float d = decay[k];
+
+        for (size_t i = 0; i < n; i++) {
+            float x = data[i];
+            sR = d*sR + x*pR;
+            sI = d*sI + x*pI;
+            float t = pR*rotR - pI*rotI;
+            pI = pR*rotI + pI*rotR;
+            pR = t;
+        }
+
+        stateR[k] = sR;
+        stateI[k] = sI;
+    }
+
+    float p = signalPower;
+    for (size_t i = 0; i < n; i++) {
+        float x = data[i];
+        p = signalDecay*p + (1 - signalDecay)*x*x;
+    }
+    signalPower = p;
+    sampleIndex += n;
+}
+
+bool StrobeDetector::detect(const RingBuffer<short>* samples, PitchEstimate* estimate) {
+    unsigned int written = samples->written();
+    size_t fresh = primed ? size_t(written - lastWritten) : STROBE_FRAME_SIZE;
+    if (fresh > samples->capacity()) {
+        // We fell too far behind, the state no longer matches the signal
+        reset();
+        fresh = STROBE_FRAME_SIZE;
+    }
+    lastWritten = written;
+    if (fresh == 0) {
+        if (lastDetected)
+            *estimate = lastEstimate;
+        return lastDetected;
+    }
+
+    RingBuffer<short>::Span first, second;
+    samples->latest(fresh, &first, &second);
+    process(first.data, first.size);
+    process(second.data, second.size);
+    primed = true;
+
+    // Best offset by power summed over the harmonics
+    float score[STROBE_OFFSETS];
+    int best = 0;
+    for (int o = 0; o < STROBE_OFFSETS; o++) {
+        score[o] = 0;
+        for (int h = 0; h < STROBE_HARMONICS; h++) {
+            int k = h*STROBE_OFFSETS + o;
+            score[o] += (stateR[k]*stateR[k] + stateI[k]*stateI[k])*gain[k]*gain[k];
+        }
+        if (score[o] > score[best])
+            best = o;
+    }
+
+    int strongest = best;
+    float strongestPower = 0;
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        int k = h*STROBE_OFFSETS + best;
+        float power = (stateR[k]*stateR[k] + stateI[k]*stateI[k])*gain[k]*gain[k];
+        if (power > strongestPower) {
+            strongestPower = power;
+            strongest = k;
+        }
+    }
+
+    float amplitude = sqrt(strongestPower);
+    // A sine of amplitude A has a mean square of A*A/2
+    if (amplitude < STROBE_MIN_AMPLITUDE || strongestPower/2 < STROBE_MIN_POWER_RATIO*signalPower) {
+        lastFilter = -1;
+        lastDetected = false;
+        return false;
+    }
+
+    // Coarse offset from a parabola through the log scores of the neighbouring offsets
+    float cents = best*STROBE_STEP_CENTS - STROBE_SPAN_CENTS;
+    if (best > 0 && best < STROBE_OFFSETS - 1) {
+        float l = log(score[best-1] + 1e-20f);
+        float c = log(score[best] + 1e-20f);
+        float r = log(score[best+1] + 1e-20f);
+        float denominator = l - 2*c + r;
+        if (denominator < 0)
+            cents += STROBE_STEP_CENTS*0.5f*(l - r)/denominator;
+    }
+    float harmonic = strongest/STROBE_OFFSETS + 1;
+    float frequency = targetFreq*pow(2.0f, cents/1200);
+
+    // Fine offset from the phase drift of the strongest filter since the last call. The
+    // coarse estimate predicts the drift, which resolves the 2*pi ambiguity of the
+    // measured one.
+    float now = atan2(stateI[strongest], stateR[strongest]);
+    if (strongest == lastFilter) {
+        double elapsed = sampleIndex - lastPhaseIndex;
+        double filterFreq = omega[strongest]*sampleRate/(2*M_PI);
+        double predicted = 2*M_PI*(harmonic*frequency - filterFreq)*elapsed/sampleRate;
+        double measured = now - phase[strongest];
+        measured += 2*M_PI*floor((predicted - measured)/(2*M_PI) + 0.5);
+        frequency = (filterFreq + measured*sampleRate/(2*M_PI*elapsed))/harmonic;
+    }
+    for (int k = 0; k < STROBE_FILTERS; k++)
+        phase[k] = atan2(stateI[k], stateR[k]);
+    lastFilter = strongest;
+    lastPhaseIndex = sampleIndex;
+
+    estimate->frequency = frequency;
+    estimate->amplitude = amplitude;
+    estimate->overtone = 1;
+    lastEstimate = *estimate;
+    lastDetected = true;
+    return true;
+}
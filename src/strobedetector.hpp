@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef StrobeDetector_HPP_
+#define StrobeDetector_HPP_
+
+#include "pitchdetector.hpp"
+
+#define STROBE_SPAN_CENTS 50
+#define STROBE_STEP_CENTS 10
+#define STROBE_HARMONICS 3
+#define STROBE_OFFSETS (2*STROBE_SPAN_CENTS/STROBE_STEP_CENTS + 1)
+#define STROBE_FILTERS (STROBE_OFFSETS*STROBE_HARMONICS)
+// Samples looked at when there is no previous state to continue from
+#define STROBE_FRAME_SIZE 2048
+// Filter outputs weaker than this (sine amplitude in S16 sample units) count as silence
+#define STROBE_MIN_AMPLITUDE 20.0f
+// The strongest filter must hold at least this fraction of the signal power, noise
+// spreads its power over the whole band and leaves every filter with a sliver of it
+#define STROBE_MIN_POWER_RATIO 0.1f
+
+/*
+ * Strobe tuner for a known target note. A small bank of recursive single-bin DFT filters
+ * sits on the target frequency and its first harmonics, spaced a few cents apart across
+ * +-50 cents. Each filter is a leaky phasor accumulator updated once per incoming sample,
+ * so the detector only ever processes the samples that arrived since its last call.
+ *
+ * The best matching offset is found by summing filter power over the harmonics, and the
+ * reading is refined from how fast the phase of the strongest filter drifts between
+ * calls, which is what the spinning disc of a mechanical strobe tuner shows.
+ */
+class StrobeDetector : public PitchDetector {
+public:
+    StrobeDetector(int sampleRate);
+    virtual ~StrobeDetector();
+
+    virtual const char* name() const { return "strobe"; }
+    virtual size_t frameSize() const { return STROBE_FRAME_SIZE; }
+    virtual bool detect(const RingBuffer<short>* samples, PitchEstimate* estimate);
+
+    void setTarget(float frequency);
+    float target() const { return targetFreq; }
+    // Forgets the filter states, e.g. before analysing an unrelated recording
+    void reset();
+
+private:
+    void process(const short* data, size_t n);
+
+    int sampleRate;
+    float targetFreq;
+
+    double omega[STROBE_FILTERS];
+    float decay[STROBE_FILTERS];
+    float gain[STROBE_FILTERS];
+    float stateR[STROBE_FILTERS];
+    float stateI[STROBE_FILTERS];
+    float phase[STROBE_FILTERS];
+    // Mean square of the input, leaking like the fundamental filters do
+    float signalDecay;
+    float signalPower;
+
+    bool primed;
+    int lastFilter;
+    double sampleIndex;
+    double lastPhaseIndex;
+    unsigned int lastWritten;
+    // Given again by calls that see no new samples, there is no drift to measure
+    bool lastDetected;
+    PitchEstimate lastEstimate;
+};
+
+#endif /* StrobeDetector_HPP_ */
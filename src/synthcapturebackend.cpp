@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "synthcapturebackend.hpp"
+
+#include <math.h>
+#include <string.h>
+
+SynthCaptureBackend::SynthCaptureBackend(int sampleRate, const QList<float>& frequencies, float amplitude)
+    : rate(sampleRate), frequencies(frequencies), amplitude(amplitude) {
+    phases = new double[frequencies.size()];
+    memset(phases, 0, sizeof(double)*frequencies.size());
+    noiseState = 1;
+    fragBuff = new short[DEFAULT_FRAGMENT_SIZE];
+}
+
+SynthCaptureBackend::~SynthCaptureBackend() {
+    delete[] phases;
+    delete[] fragBuff;
+}
+
+bool SynthCaptureBackend::open() {
+    memset(phases, 0, sizeof(double)*frequencies.size());
+    pacer.start(rate);
+    for (int c = 0; c < frequencies.size(); c++) {
+        if (frequencies[c] <= 0 || frequencies[c] >= rate/2)
+            return false;
+    }
+    return !frequencies.isEmpty();
+}
+
+bool SynthCaptureBackend::pause() {
+    return true;
+}
+
+bool SynthCaptureBackend::resume() {
+    pacer.start(rate);
+    return true;
+}
+
+int SynthCaptureBackend::capture(RingBuffer<short>* const* samples, int timeoutUs) {
+    if (!pacer.wait(DEFAULT_FRAGMENT_SIZE, timeoutUs))
+        return 0;
+
+    for (int c = 0; c < frequencies.size(); c++) {
+        generate(frequencies[c], &phases[c]);
+        samples[c]->write(fragBuff, DEFAULT_FRAGMENT_SIZE);
+    }
+    return DEFAULT_FRAGMENT_SIZE;
+}
+
+void SynthCaptureBackend::generate(float frequency, double* phase) {
+    double step = 2*M_PI*frequency/rate;
+    for (size_t i = 0; i < DEFAULT_FRAGMENT_SIZE; i++) {
+        float value = 0;
+        float partial = amplitude;
+        for (int h = 1; h <= SYNTH_HARMONICS; h++) {
+            value += partial*float(sin(h*(*phase)));
+            partial *= 0.5f;
+        }
+        // Linear congruential noise is plenty here and cheaper than rand()
+        noiseState = noiseState*1103515245 + 12345;
+        value += float(int((noiseState >> 16) % (2*SYNTH_NOISE + 1)) - SYNTH_NOISE);
+
+        fragBuff[i] = short(value);
+        *phase += step;
+        if (*phase > 2*M_PI)
+            *phase -= 2*M_PI;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SynthCaptureBackend_HPP_
+#define SynthCaptureBackend_HPP_
+
+#include <QList>
+#include "capturebackend.hpp"
+
+#define SYNTH_AMPLITUDE 8000.0f
+#define SYNTH_HARMONICS 4
+// Uniform noise added to every sample, peak value in S16 units
+#define SYNTH_NOISE 50
+
+/*
+ * Generates harmonic tones in real time, one channel per frequency: a fundamental plus
+ * SYNTH_HARMONICS - 1 overtones, each half as loud as the previous one, and a little
+ * noise. Handy for running the engine without audio hardware.
+ */
+class SynthCaptureBackend : public CaptureBackend {
+public:
+    SynthCaptureBackend(int sampleRate, const QList<float>& frequencies, float amplitude = SYNTH_AMPLITUDE);
+    virtual ~SynthCaptureBackend();
+
+    virtual const char* name() const { return "tone"; }
+    virtual bool open();
+    virtual void close() {}
+    virtual bool pause();
+    virtual bool resume();
+    virtual int sampleRate() const { return rate; }
+    virtual int channelCount() const { return frequencies.size(); }
+    virtual size_t fragmentSize() const { return DEFAULT_FRAGMENT_SIZE; }
+    virtual int capture(RingBuffer<short>* const* samples, int timeoutUs);
+    virtual int overrunCount() const { return 0; }
+
+private:
+    SynthCaptureBackend(const SynthCaptureBackend&);
+    SynthCaptureBackend& operator=(const SynthCaptureBackend&);
+
+    // Fills fragBuff with the next fragment of one channel
+    void generate(float frequency, double* phase);
+
+    int rate;
+    QList<float> frequencies;
+    float amplitude;
+    // Per channel
+    double* phases;
+    unsigned int noiseState;
+    short* fragBuff;
+    CapturePacer pacer;
+};
+
+#endif /* SynthCaptureBackend_HPP_ */
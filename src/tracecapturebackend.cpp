@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tracecapturebackend.hpp"
+
+#include <string.h>
+#include <unistd.h>
+
+TraceCaptureBackend::TraceCaptureBackend(const char* path, bool realTime, int channels)
+    : realTime(realTime), requestedChannels(channels), channels(1) {
+    strncpy(this->path, path, sizeof(this->path) - 1);
+    this->path[sizeof(this->path) - 1] = 0;
+    cursor = 0;
+    started = 0;
+}
+
+TraceCaptureBackend::~TraceCaptureBackend() {
+    close();
+}
+
+bool TraceCaptureBackend::open() {
+    if (!trace.open(path)) {
+        qDebug("%s is not a capture trace\n", path);
+        return false;
+    }
+    cursor = trace.begin();
+    started = 0;
+    channels = requestedChannels < trace.channelCount() ? requestedChannels : trace.channelCount();
+    return true;
+}
+
+void TraceCaptureBackend::close() {
+    trace.close();
+    cursor = 0;
+}
+
+bool TraceCaptureBackend::pause() {
+    return true;
+}
+
+bool TraceCaptureBackend::resume() {
+    // The next fragment is due at once, the ones after it at their recorded distance
+    started = 0;
+    return true;
+}
+
+int TraceCaptureBackend::capture(RingBuffer<short>* const* samples, int timeoutUs) {
+    CaptureTraceEntry entry;
+    size_t next = cursor;
+    do {
+        if (!trace.next(&next, &entry))
+            return -1;
+    } while (entry.type != FragmentTraceRecord);
+
+    if (realTime) {
+        qint64 now = monotonicMicros();
+        if (started == 0)
+            started = now - entry.time;
+        qint64 waitUs = started + entry.time - now;
+        if (waitUs > timeoutUs) {
+            usleep(timeoutUs);
+            return 0;
+        }
+        if (waitUs > 0)
+            usleep(useconds_t(waitUs));
+    }
+
+    for (int c = 0; c < channels; c++)
+        samples[c]->write(&entry.samples[c*entry.frames], entry.frames);
+    cursor = next;
+    return int(entry.frames);
+}
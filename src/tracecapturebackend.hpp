@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TraceCaptureBackend_HPP_
+#define TraceCaptureBackend_HPP_
+
+#include "capturebackend.hpp"
+#include "capturetrace.hpp"
+
+/*
+ * Replays the fragments of a capture trace, see RecordingCaptureBackend, exactly as they
+ * were captured: with their original sizes and, unless pacing is turned off, at their
+ * original arrival times, so overruns and scheduling hiccups come back along with the
+ * audio. Up to the requested number of channels are delivered as they were recorded,
+ * without mixing them down. The end of the trace ends the stream.
+ */
+class TraceCaptureBackend : public CaptureBackend {
+public:
+    explicit TraceCaptureBackend(const char* path, bool realTime = true, int channels = 1);
+    virtual ~TraceCaptureBackend();
+
+    virtual const char* name() const { return "trace"; }
+    virtual bool open();
+    virtual void close();
+    virtual bool pause();
+    virtual bool resume();
+    virtual int sampleRate() const { return trace.sampleRate(); }
+    virtual int channelCount() const { return channels; }
+    virtual size_t fragmentSize() const { return trace.fragmentSize(); }
+    virtual int capture(RingBuffer<short>* const* samples, int timeoutUs);
+    virtual int overrunCount() const { return 0; }
+
+private:
+    TraceCaptureBackend(const TraceCaptureBackend&);
+    TraceCaptureBackend& operator=(const TraceCaptureBackend&);
+
+    char path[256];
+    bool realTime;
+    int requestedChannels;
+    int channels;
+    CaptureTraceReader trace;
+    size_t cursor;
+    // Replay time 0 on the monotonicMicros() clock, set by the first fragment
+    qint64 started;
+};
+
+#endif /* TraceCaptureBackend_HPP_ */
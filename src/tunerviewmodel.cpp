@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tunerviewmodel.hpp"
+
+#include <math.h>
+#include <string.h>
+
+TunerViewModel::TunerViewModel(QObject* parent) : QObject(parent) {
+    monitor = NULL;
+    hasPending = false;
+    shownAny = false;
+    shownNote[0] = 0;
+    shownNegative = false;
+    shownCents = 0;
+    shownIndicator = 0;
+    track = NULL;
+    trackRate = 0;
+    trackHop = 0;
+    windowPoints = 0;
+    window = NULL;
+    trackSeen = 0;
+
+    frameTimer = new QTimer(this);
+    frameTimer->setSingleShot(true);
+    frameTimer->setInterval(VIEW_FRAME_INTERVAL_MS);
+    connect(frameTimer, SIGNAL(timeout()), this, SLOT(onFrameTimeout()));
+}
+
+TunerViewModel::~TunerViewModel() {
+    delete[] window;
+}
+
+void TunerViewModel::setLatencyMonitor(LatencyMonitor* monitor) {
+    this->monitor = monitor;
+}
+
+void TunerViewModel::setPitchTrack(const RingBuffer<PitchTrackPoint>* track, int sampleRate, size_t hop) {
+    this->track = track;
+    trackRate = sampleRate;
+    trackHop = hop;
+    delete[] window;
+    window = NULL;
+    windowPoints = 0;
+    if (track != NULL) {
+        // Leave the analysis plenty of room to write while the window is copied
+        windowPoints = qMin(size_t(sampleRate/1000.0f*VIBRATO_WINDOW_MS/hop), track->capacity()/2);
+        window = new PitchTrackPoint[windowPoints];
+        trackSeen = track->written();
+    }
+}
+
+void TunerViewModel::updateReading(const NoteInfo& note) {
+    if (hasPending && monitor != NULL)
+        monitor->count(CoalescedReadingCounter);
+    pending = note;
+    hasPending = true;
+    if (!frameTimer->isActive())
+        present();
+}
+
+void TunerViewModel::onFrameTimeout() {
+    // Nothing new during the frame, the next reading is shown right away
+    if (hasPending)
+        present();
+}
+
+void TunerViewModel::present() {
+    hasPending = false;
+    show(pending);
+    showVibrato();
+    if (monitor != NULL)
+        monitor->recordDisplayed(pending.timing);
+    frameTimer->start();
+}
+
+void TunerViewModel::show(const NoteInfo& note) {
+    bool hasNote = note.note[0] != 0;
+    bool negative = note.centsDiff < 0;
+    int cents = int(fabs(note.centsDiff));
+
+    int indicator;
+    if (note.centsDiff <= -INDICATOR_BIG_DIFF)
+        indicator = -2;
+    else if (note.centsDiff <= -INDICATOR_SMALL_DIFF)
+        indicator = -1;
+    else if (note.centsDiff < INDICATOR_SMALL_DIFF)
+        indicator = 0;
+    else if (note.centsDiff < INDICATOR_BIG_DIFF)
+        indicator = 1;
+    else
+        indicator = 2;
+
+    bool noteDiffers = !shownAny || strcmp(note.note, shownNote) != 0;
+    if (noteDiffers) {
+        strncpy(shownNote, note.note, sizeof(shownNote) - 1);
+        shownNote[sizeof(shownNote) - 1] = 0;
+        noteText = hasNote ? QString(shownNote) : QObject::tr("I'm listening...");
+        emit noteChanged(noteText);
+    }
+
+    if (noteDiffers || negative != shownNegative || cents != shownCents) {
+        shownNegative = negative;
+        shownCents = cents;
+        QString text;
+        if (hasNote)
+            text.sprintf("%c%d\n", negative ? '-' : '+', cents);
+        if (text != centsText) {
+            centsText = text;
+            emit centsChanged(centsText);
+        }
+    }
+
+    if (!shownAny || indicator != shownIndicator) {
+        shownIndicator = indicator;
+        emit indicatorChanged(shownIndicator);
+    }
+    shownAny = true;
+}
+
+void TunerViewModel::showVibrato() {
+    QString text;
+    float depth, rate;
+    if (measureVibrato(&depth, &rate) && depth >= VIBRATO_MIN_DEPTH
+            && rate >= VIBRATO_MIN_RATE && rate <= VIBRATO_MAX_RATE)
+        text = QObject::tr("Vibrato %1 cents at %2 Hz").arg(int(depth + 0.5f)).arg(rate, 0, 'f', 1);
+    if (text != vibratoText) {
+        vibratoText = text;
+        emit vibratoChanged(vibratoText);
+    }
+}
+
+bool TunerViewModel::measureVibrato(float* depth, float* rate) {
+    if (track == NULL || windowPoints < 2)
+        return false;
+    // The track only grows while the vocoder hears a pitch, an old stretch is no vibrato
+    unsigned int written = track->written();
+    bool grown = written != trackSeen;
+    trackSeen = written;
+    if (!grown || written < windowPoints)
+        return false;
+    track->copyLatest(window, windowPoints);
+    for (size_t i = 1; i < windowPoints; i++) {
+        if (window[i].position - window[i - 1].position != trackHop)
+            return false;
+    }
+
+    float low = window[0].cents, high = low, mean = 0.0f;
+    for (size_t i = 0; i < windowPoints; i++) {
+        low = qMin(low, window[i].cents);
+        high = qMax(high, window[i].cents);
+        mean += window[i].cents;
+    }
+    mean /= windowPoints;
+    *depth = (high - low)/2;
+
+    // Time the crossings of the mean, two per period, with some hysteresis so that
+    // noise around the mean does not add any
+    float threshold = *depth/2;
+    int side = 0, crossings = 0;
+    size_t first = 0, last = 0;
+    for (size_t i = 0; i < windowPoints; i++) {
+        float offset = window[i].cents - mean;
+        int now = offset > threshold ? 1 : offset < -threshold ? -1 : side;
+        if (side != 0 && now != side) {
+            if (crossings == 0)
+                first = i;
+            last = i;
+            crossings++;
+        }
+        side = now;
+    }
+    *rate = crossings > 1 ? (crossings - 1)/2.0f*trackRate/((last - first)*trackHop) : 0.0f;
+    return true;
+}
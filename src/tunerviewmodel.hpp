@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TunerViewModel_HPP_
+#define TunerViewModel_HPP_
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include "latencymonitor.hpp"
+#include "noteinfo.hpp"
+#include "pitchanalyser.hpp"
+#include "ringbuffer.hpp"
+
+// Shortest time between two updates of the display, a frame at 60 Hz
+#define VIEW_FRAME_INTERVAL_MS 16
+// Cents off at which the indicator moves one step away from in tune, and two steps
+#define INDICATOR_SMALL_DIFF 5
+#define INDICATOR_BIG_DIFF 25
+// Stretch of uninterrupted pitch track the vibrato is measured over, and the least
+// depth in cents and range of rates in Hz it is shown for
+#define VIBRATO_WINDOW_MS 1000
+#define VIBRATO_MIN_DEPTH 3
+#define VIBRATO_MIN_RATE 3.0f
+#define VIBRATO_MAX_RATE 12.0f
+
+/*
+ * State of the tuner display as properties for main.qml to bind to. Readings may arrive
+ * much faster than the display refreshes, so they are coalesced: a reading is shown
+ * right away if none was shown during the last frame, otherwise it waits for the end of
+ * the frame and is replaced by any newer one in the meantime. Properties only change,
+ * and their strings are only rebuilt, when what they show changes. Lives on the UI
+ * thread.
+ *
+ * With a pitch track, see setPitchTrack(), the depth and rate of any vibrato are taken
+ * from its last VIBRATO_WINDOW_MS whenever a reading is shown.
+ */
+class TunerViewModel : public QObject {
+    Q_OBJECT
+    // Note name, or a prompt while there is no note
+    Q_PROPERTY(QString note READ note NOTIFY noteChanged)
+    // Signed offset in cents, empty while there is no note
+    Q_PROPERTY(QString cents READ cents NOTIFY centsChanged)
+    // -2 far flat, -1 flat, 0 in tune, 1 sharp, 2 far sharp
+    Q_PROPERTY(int indicator READ indicator NOTIFY indicatorChanged)
+    // Depth and rate of the vibrato, empty while there is none or no pitch track
+    Q_PROPERTY(QString vibrato READ vibrato NOTIFY vibratoChanged)
+
+public:
+    explicit TunerViewModel(QObject* parent = 0);
+    virtual ~TunerViewModel();
+
+    QString note() const { return noteText; }
+    QString cents() const { return centsText; }
+    int indicator() const { return shownIndicator; }
+    QString vibrato() const { return vibratoText; }
+
+    void updateReading(const NoteInfo& note);
+
+    // Where shown and coalesced readings are recorded, NULL while nothing is captured
+    void setLatencyMonitor(LatencyMonitor* monitor);
+    // Track of the channel on display with a point every hop samples, NULL for none
+    void setPitchTrack(const RingBuffer<PitchTrackPoint>* track, int sampleRate, size_t hop);
+
+Q_SIGNALS:
+    void noteChanged(QString note);
+    void centsChanged(QString cents);
+    void indicatorChanged(int indicator);
+    void vibratoChanged(QString vibrato);
+
+private Q_SLOTS:
+    void onFrameTimeout();
+
+private:
+    TunerViewModel(const TunerViewModel&);
+    TunerViewModel& operator=(const TunerViewModel&);
+
+    void present();
+    void show(const NoteInfo& note);
+    void showVibrato();
+    // Measures the vibrato over the newest points of the track, false if there is
+    // no stretch of VIBRATO_WINDOW_MS without a gap
+    bool measureVibrato(float* depth, float* rate);
+
+    QTimer* frameTimer;
+    LatencyMonitor* monitor;
+    NoteInfo pending;
+    bool hasPending;
+
+    // What is on display, to tell what changed
+    bool shownAny;
+    char shownNote[16];
+    bool shownNegative;
+    int shownCents;
+    int shownIndicator;
+    QString noteText;
+    QString centsText;
+
+    const RingBuffer<PitchTrackPoint>* track;
+    int trackRate;
+    size_t trackHop;
+    // Points in a window, and a copy of the newest of them
+    size_t windowPoints;
+    PitchTrackPoint* window;
+    // RingBuffer::written() of the track when the vibrato was last measured
+    unsigned int trackSeen;
+    QString vibratoText;
+};
+
+#endif /* TunerViewModel_HPP_ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wavcapturebackend.hpp"
+
+#include <string.h>
+
+WavCaptureBackend::WavCaptureBackend(const char* path, bool realTime, int channels)
+    : realTime(realTime), requestedChannels(channels), channels(1) {
+    strncpy(this->path, path, sizeof(this->path) - 1);
+    this->path[sizeof(this->path) - 1] = 0;
+    position = 0;
+    fragBuff = NULL;
+}
+
+WavCaptureBackend::~WavCaptureBackend() {
+    close();
+}
+
+bool WavCaptureBackend::open() {
+    if (!file.open(path))
+        return false;
+
+    position = 0;
+    channels = requestedChannels < file.channelCount() ? requestedChannels : file.channelCount();
+    fragBuff = new short[DEFAULT_FRAGMENT_SIZE];
+    pacer.start(file.sampleRate());
+    return true;
+}
+
+void WavCaptureBackend::close() {
+    file.close();
+    position = 0;
+    delete[] fragBuff;
+    fragBuff = NULL;
+}
+
+bool WavCaptureBackend::pause() {
+    return true;
+}
+
+bool WavCaptureBackend::resume() {
+    // Carry on from the same position, without catching up on the pause
+    pacer.start(file.sampleRate());
+    return true;
+}
+
+int WavCaptureBackend::capture(RingBuffer<short>* const* samples, int timeoutUs) {
+    size_t n = remaining() < DEFAULT_FRAGMENT_SIZE ? remaining() : DEFAULT_FRAGMENT_SIZE;
+    if (n == 0)
+        return -1;
+    if (realTime && !pacer.wait(n, timeoutUs))
+        return 0;
+
+    if (channels > 1 || file.channelCount() == 1) {
+        writeInterleaved(&file.data()[position*file.channelCount()], n, file.channelCount(),
+                samples, channels);
+    } else {
+        file.mixDown(position, n, fragBuff);
+        samples[0]->write(fragBuff, n);
+    }
+    position += n;
+    return int(n);
+}
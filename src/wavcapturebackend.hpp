@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WavCaptureBackend_HPP_
+#define WavCaptureBackend_HPP_
+
+#include "capturebackend.hpp"
+#include "mappedaudiofile.hpp"
+
+/*
+ * Plays back a 16 bit PCM WAV file as if it was being captured. Mono files go from the
+ * file mapping straight into the ring buffer. Multi-channel files are mixed down when a
+ * single channel is asked for, otherwise up to that many of their channels are
+ * delivered separately.
+ * Samples are delivered in real time unless pacing is turned off, e.g. for offline
+ * analysis; the end of the file ends the stream.
+ */
+class WavCaptureBackend : public CaptureBackend {
+public:
+    explicit WavCaptureBackend(const char* path, bool realTime = true, int channels = 1);
+    virtual ~WavCaptureBackend();
+
+    virtual const char* name() const { return "wav"; }
+    virtual bool open();
+    virtual void close();
+    virtual bool pause();
+    virtual bool resume();
+    virtual int sampleRate() const { return file.sampleRate(); }
+    virtual int channelCount() const { return channels; }
+    virtual size_t fragmentSize() const { return DEFAULT_FRAGMENT_SIZE; }
+    virtual int capture(RingBuffer<short>* const* channels, int timeoutUs);
+    virtual int overrunCount() const { return 0; }
+
+    // Samples per channel left in the file
+    size_t remaining() const { return file.frames() - position; }
+
+private:
+    WavCaptureBackend(const WavCaptureBackend&);
+    WavCaptureBackend& operator=(const WavCaptureBackend&);
+
+    char path[256];
+    bool realTime;
+    int requestedChannels;
+    int channels;
+    MappedAudioFile file;
+    size_t position;
+    short* fragBuff;
+    CapturePacer pacer;
+};
+
+#endif /* WavCaptureBackend_HPP_ */
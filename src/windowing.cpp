@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "windowing.hpp"
+
+#include <QMutexLocker>
+#include <math.h>
+#include "fftplancache.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled in through a function target attribute and only used when the
+// CPU reports it, so the rest of the binary does not require it
+#if (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define HAVE_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+Q_GLOBAL_STATIC(WindowCache, sharedWindowCache)
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x/(2*k))*(x/(2*k));
+        sum += term;
+        if (term < sum*1e-12)
+            break;
+    }
+    return sum;
+}
+
+static double windowCoefficient(WindowType type, size_t i, size_t n) {
+    double m = n > 1 ? double(n - 1) : 1.0;
+    double x = 2*M_PI*i/m;
+    switch (type) {
+    case BlackmanHarrisWindow:
+        return 0.35875 - 0.48829*cos(x) + 0.14128*cos(2*x) - 0.01168*cos(3*x);
+    case KaiserWindow: {
+        double r = 2.0*i/m - 1.0;
+        return besselI0(KAISER_BETA*sqrt(1.0 - r*r))/besselI0(KAISER_BETA);
+    }
+    case RectangularWindow:
+        return 1.0;
+    case HannWindow:
+    default:
+        return 0.5*(1 - cos(x));
+    }
+}
+
+static void computeWindow(WindowType type, float* table, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        table[i] = float(windowCoefficient(type, i, n));
+}
+
+static void computeWindow(WindowType type, qint16* table, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        table[i] = qint16(floor(windowCoefficient(type, i, n)*32767 + 0.5));
+}
+
+static void computeWindow(WindowType type, qint32* table, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        table[i] = qint32(floor(windowCoefficient(type, i, n)*2147483647.0 + 0.5));
+}
+
+WindowCache::WindowCache() {
+}
+
+WindowCache::~WindowCache() {
+    for (QMap<quint64, float*>::const_iterator it = tables.constBegin(); it != tables.constEnd(); ++it)
+        freeAligned(it.value());
+    for (QMap<quint64, qint16*>::const_iterator it = q15Tables.constBegin(); it != q15Tables.constEnd(); ++it)
+        freeAligned(it.value());
+    for (QMap<quint64, qint32*>::const_iterator it = q31Tables.constBegin(); it != q31Tables.constEnd(); ++it)
+        freeAligned(it.value());
+}
+
+WindowCache* WindowCache::shared() {
+    return sharedWindowCache();
+}
+
+const float* WindowCache::table(WindowType type, size_t n) {
+    quint64 key = (quint64(n) << 8) | quint64(type);
+
+    QMutexLocker locker(&mutex);
+    QMap<quint64, float*>::const_iterator it = tables.constFind(key);
+    if (it != tables.constEnd())
+        return it.value();
+
+    float* table = (float*)allocAligned(sizeof(float)*n);
+    computeWindow(type, table, n);
+    tables.insert(key, table);
+    return table;
+}
+
+const qint16* WindowCache::q15Table(WindowType type, size_t n) {
+    quint64 key = (quint64(n) << 8) | quint64(type);
+
+    QMutexLocker locker(&mutex);
+    QMap<quint64, qint16*>::const_iterator it = q15Tables.constFind(key);
+    if (it != q15Tables.constEnd())
+        return it.value();
+
+    qint16* table = (qint16*)allocAligned(sizeof(qint16)*n);
+    computeWindow(type, table, n);
+    q15Tables.insert(key, table);
+    return table;
+}
+
+const qint32* WindowCache::q31Table(WindowType type, size_t n) {
+    quint64 key = (quint64(n) << 8) | quint64(type);
+
+    QMutexLocker locker(&mutex);
+    QMap<quint64, qint32*>::const_iterator it = q31Tables.constFind(key);
+    if (it != q31Tables.constEnd())
+        return it.value();
+
+    qint32* table = (qint32*)allocAligned(sizeof(qint32)*n);
+    computeWindow(type, table, n);
+    q31Tables.insert(key, table);
+    return table;
+}
+
+void windowSamplesScalar(const short* in, const float* window, float* out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = float(in[i])*window[i];
+}
+
+#if defined(__SSE2__)
+static void windowSamplesSse2(const short* in, const float* window, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)&in[i]);
+        // Sign-extend by placing each sample in the upper half and shifting it back down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_loadu_ps(&window[i])));
+        _mm_storeu_ps(&out[i+4], _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_loadu_ps(&window[i+4])));
+    }
+    windowSamplesScalar(&in[i], &window[i], &out[i], n - i);
+}
+#endif
+
+#if defined(HAVE_AVX2_KERNEL)
+__attribute__((target("avx2")))
+static void windowSamplesAvx2(const short* in, const float* window, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)&in[i]));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)&in[i+8]));
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_cvtepi32_ps(lo), _mm256_loadu_ps(&window[i])));
+        _mm256_storeu_ps(&out[i+8], _mm256_mul_ps(_mm256_cvtepi32_ps(hi), _mm256_loadu_ps(&window[i+8])));
+    }
+    windowSamplesScalar(&in[i], &window[i], &out[i], n - i);
+}
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+static void windowSamplesNeon(const short* in, const float* window, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t s = vld1q_s16(&in[i]);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(&out[i], vmulq_f32(lo, vld1q_f32(&window[i])));
+        vst1q_f32(&out[i+4], vmulq_f32(hi, vld1q_f32(&window[i+4])));
+    }
+    windowSamplesScalar(&in[i], &window[i], &out[i], n - i);
+}
+#endif
+
+static WindowKernel selectWindowKernel(const char** name) {
+#if defined(HAVE_AVX2_KERNEL)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return windowSamplesAvx2;
+    }
+#endif
+#if defined(__SSE2__)
+    *name = "sse2";
+    return windowSamplesSse2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    *name = "neon";
+    return windowSamplesNeon;
+#else
+    *name = "scalar";
+    return windowSamplesScalar;
+#endif
+}
+
+WindowKernel windowKernel(const char** name) {
+    static const char* kernelName = NULL;
+    static WindowKernel kernel = selectWindowKernel(&kernelName);
+    if (name != NULL)
+        *name = kernelName;
+    return kernel;
+}
+
+size_t windowKernels(WindowKernel* kernels, const char** names, size_t max) {
+    size_t count = 0;
+    if (count < max) {
+        kernels[count] = windowSamplesScalar;
+        names[count++] = "scalar";
+    }
+#if defined(__SSE2__)
+    if (count < max) {
+        kernels[count] = windowSamplesSse2;
+        names[count++] = "sse2";
+    }
+#endif
+#if defined(HAVE_AVX2_KERNEL)
+    __builtin_cpu_init();
+    if (count < max && __builtin_cpu_supports("avx2")) {
+        kernels[count] = windowSamplesAvx2;
+        names[count++] = "avx2";
+    }
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    if (count < max) {
+        kernels[count] = windowSamplesNeon;
+        names[count++] = "neon";
+    }
+#endif
+    return count;
+}
+
+void windowSamplesQ15(const short* in, const qint16* window, qint16* out, size_t n) {
+    size_t i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    // Rounding doubling multiply high is exactly the rounded Q15 product
+    for (; i + 8 <= n; i += 8)
+        vst1q_s16(&out[i], vqrdmulhq_s16(vld1q_s16(&in[i]), vld1q_s16(&window[i])));
+#endif
+    for (; i < n; i++)
+        out[i] = qint16((qint32(in[i])*window[i] + (1 << 14)) >> 15);
+}
+
+void windowSamplesQ31(const short* in, const qint32* window, qint32* out, size_t n) {
+    // (in << 16)*window >> 31, without the shift up
+    for (size_t i = 0; i < n; i++)
+        out[i] = qint32((qint64(in[i])*window[i] + (1 << 14)) >> 15);
+}
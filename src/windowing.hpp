@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef Windowing_HPP_
+#define Windowing_HPP_
+
+#include <QMap>
+#include <QMutex>
+#include <QtGlobal>
+#include <stddef.h>
+
+#define KAISER_BETA 8.6
+
+enum WindowType {
+    HannWindow,
+    BlackmanHarrisWindow,
+    KaiserWindow,
+    // No window at all, for comparisons
+    RectangularWindow
+};
+
+/*
+ * Process-wide cache of window coefficient tables. A table is computed once per type and
+ * size and is read-only afterwards, so the returned pointer can be used from any thread.
+ * Besides float there are Q15 and Q31 tables for the fixed point FFT.
+ */
+class WindowCache {
+public:
+    WindowCache();
+    ~WindowCache();
+
+    static WindowCache* shared();
+
+    const float* table(WindowType type, size_t n);
+    const qint16* q15Table(WindowType type, size_t n);
+    const qint32* q31Table(WindowType type, size_t n);
+
+private:
+    WindowCache(const WindowCache&);
+    WindowCache& operator=(const WindowCache&);
+
+    QMutex mutex;
+    QMap<quint64, float*> tables;
+    QMap<quint64, qint16*> q15Tables;
+    QMap<quint64, qint32*> q31Tables;
+};
+
+// Converts n signed 16 bit samples to floats and multiplies them by the window
+// coefficients in a single pass: out[i] = in[i]*window[i]
+typedef void (*WindowKernel)(const short* in, const float* window, float* out, size_t n);
+
+// Scalar reference implementation, available everywhere
+void windowSamplesScalar(const short* in, const float* window, float* out, size_t n);
+
+// Fastest kernel supported by the CPU we are running on, selected on first use
+WindowKernel windowKernel(const char** name = NULL);
+
+// Every kernel the CPU supports, the scalar reference first, with their names, so that
+// they can be checked against each other. Returns how many there are, at most max.
+size_t windowKernels(WindowKernel* kernels, const char** names, size_t max);
+
+// Fixed point variants for FixedFftPlan: the samples as Q15 times Q15 coefficients, and
+// the samples widened to Q31 times Q31 coefficients, both rounded
+void windowSamplesQ15(const short* in, const qint16* window, qint16* out, size_t n);
+void windowSamplesQ31(const short* in, const qint32* window, qint32* out, size_t n);
+
+#endif /* Windowing_HPP_ */
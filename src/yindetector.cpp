@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yindetector.hpp"
+
+#include <math.h>
+#include <string.h>
+
+YinDetector::YinDetector(int sampleRate, size_t frameSize) : sampleRate(sampleRate), frameLength(frameSize) {
+    forwardPlan = FftPlanCache::shared()->plan(frameLength);
+    inversePlan = FftPlanCache::shared()->plan(frameLength, true);
+    fftWorkspace = new FftWorkspace();
+    fftWorkspace->reserve(frameLength);
+    frame = (float*)allocAligned(sizeof(float)*frameLength);
+    frameSpectrum = (kiss_fft_cpx*)allocAligned(sizeof(kiss_fft_cpx)*(frameLength/2 + 1));
+    difference = (float*)allocAligned(sizeof(float)*(frameLength/2));
+}
+
+YinDetector::~YinDetector() {
+    delete fftWorkspace;
+    freeAligned(frame);
+    freeAligned(frameSpectrum);
+    freeAligned(difference);
+}
+
+bool YinDetector::detect(const RingBuffer<short>* samples, PitchEstimate* estimate) {
+    size_t n = frameLength;
+    size_t w = n/2;
+
+    RingBuffer<short>::Span first, second;
+    samples->latest(n, &first, &second);
+    for (size_t i = 0; i < first.size; i++)
+        frame[i] = first.data[i];
+    for (size_t i = 0; i < second.size; i++)
+        frame[first.size + i] = second.data[i];
+
+    double energy = 0;
+    for (size_t i = 0; i < n; i++)
+        energy += double(frame[i])*frame[i];
+    float rms = sqrt(energy/n);
+    if (rms < YIN_MIN_RMS)
+        return false;
+
+    // r(tau) = sum x[j]*x[j+tau] for j < w is the correlation of the first half of the
+    // frame with the whole frame. Since j+tau < n there is no circular wrap-around and a
+    // frame-sized FFT is enough.
+    kiss_fft_scalar* timeData = fftWorkspace->timeData();
+    kiss_fft_cpx* freqData = fftWorkspace->freqData();
+    memcpy(timeData, frame, sizeof(float)*n);
+    forwardPlan->forward(timeData, frameSpectrum, fftWorkspace->scratch());
+    memcpy(timeData, frame, sizeof(float)*w);
+    memset(&timeData[w], 0, sizeof(float)*(n - w));
+    forwardPlan->forward(timeData, freqData, fftWorkspace->scratch());
+    for (size_t k = 0; k <= n/2; k++) {
+        kiss_fft_cpx a = freqData[k];
+        kiss_fft_cpx b = frameSpectrum[k];
+        freqData[k].r = a.r*b.r + a.i*b.i;
+        freqData[k].i = a.r*b.i - a.i*b.r;
+    }
+    inversePlan->backward(freqData, timeData, fftWorkspace->scratch());
+
+    // Difference function d(tau) = e(0) + e(tau) - 2r(tau), where e(tau) is the energy of
+    // the w samples starting at tau, turned into the cumulative mean normalised
+    // difference d'(tau) = d(tau)*tau/sum(d(1..tau)) in the same pass
+    double e0 = 0;
+    for (size_t j = 0; j < w; j++)
+        e0 += double(frame[j])*frame[j];
+    double eTau = e0;
+    double runningSum = 0;
+    difference[0] = 1;
+    for (size_t tau = 1; tau < w; tau++) {
+        eTau += double(frame[tau + w - 1])*frame[tau + w - 1] - double(frame[tau - 1])*frame[tau - 1];
+        double d = e0 + eTau - 2.0*timeData[tau]/n;
+        if (d < 0)
+            d = 0;
+        runningSum += d;
+        difference[tau] = runningSum > 0 ? float(d*tau/runningSum) : 1;
+    }
+
+    // First dip below the threshold, followed down to its minimum. Fall back to the
+    // deepest dip if it is still reasonably periodic.
+    size_t tau = 0;
+    size_t minTau = 2;
+    for (size_t t = minTau; t < w - 1; t++) {
+        if (difference[t] < YIN_THRESHOLD) {
+            while (t + 1 < w - 1 && difference[t + 1] < difference[t])
+                t++;
+            tau = t;
+            break;
+        }
+        if (difference[t] < difference[minTau])
+            minTau = t;
+    }
+    if (tau == 0) {
+        if (difference[minTau] > YIN_MAX_APERIODICITY)
+            return false;
+        tau = minTau;
+    }
+
+    // Parabolic interpolation of the dip for sub-sample period precision
+    float refinedTau = tau;
+    float y0 = difference[tau - 1];
+    float y1 = difference[tau];
+    float y2 = difference[tau + 1];
+    float denominator = y0 - 2*y1 + y2;
+    if (denominator > 0)
+        refinedTau += 0.5f*(y0 - y2)/denominator;
+
+    estimate->frequency = sampleRate/refinedTau;
+    estimate->amplitude = rms;
+    estimate->overtone = 1;
+    return true;
+}
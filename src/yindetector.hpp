@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YinDetector_HPP_
+#define YinDetector_HPP_
+
+#include "kiss_fft.h"
+#include "fftplancache.hpp"
+#include "pitchdetector.hpp"
+
+#define YIN_FRAME_SIZE 4096
+// Dips of the normalised difference function below this are taken as periods
+#define YIN_THRESHOLD 0.15f
+// Dips above this are too weak to be trusted even if they are the deepest ones
+#define YIN_MAX_APERIODICITY 0.5f
+// Frames quieter than this RMS (in S16 sample units) are treated as silence
+#define YIN_MIN_RMS 20.0f
+
+/*
+ * YIN time-domain pitch detector (de Cheveigne & Kawahara, 2002). The difference function
+ * is derived from an autocorrelation computed with FFTs, so a frame costs two forward
+ * and one inverse FFT of frameSize points. With the default 4096-sample frame the lowest
+ * detectable frequency is sampleRate/2048, about 21.5 Hz at 44.1 kHz, and a first reading
+ * is available after less than 100 ms of audio.
+ */
+class YinDetector : public PitchDetector {
+public:
+    YinDetector(int sampleRate, size_t frameSize = YIN_FRAME_SIZE);
+    virtual ~YinDetector();
+
+    virtual const char* name() const { return "yin"; }
+    virtual size_t frameSize() const { return frameLength; }
+    virtual bool detect(const RingBuffer<short>* samples, PitchEstimate* estimate);
+
+private:
+    YinDetector(const YinDetector&);
+    YinDetector& operator=(const YinDetector&);
+
+    int sampleRate;
+    size_t frameLength;
+    const FftPlan* forwardPlan;
+    const FftPlan* inversePlan;
+    FftWorkspace* fftWorkspace;
+    float* frame;
+    kiss_fft_cpx* frameSpectrum;
+    float* difference;
+};
+
+#endif /* YinDetector_HPP_ */
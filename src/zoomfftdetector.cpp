@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "zoomfftdetector.hpp"
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+ZoomFftDetector::ZoomFftDetector(int sampleRate, size_t frameSize) : sampleRate(sampleRate), coarseSize(frameSize) {
+    coarsePlan = FftPlanCache::shared()->plan(coarseSize);
+    zoomPlan = FftPlanCache::shared()->complexPlan(ZOOM_FFT_SIZE);
+    fftWorkspace = new FftWorkspace();
+    fftWorkspace->reserve(coarseSize);
+    window = WindowCache::shared()->table(HannWindow, coarseSize);
+    windowSamples = windowKernel();
+    zoomIn = (kiss_fft_cpx*)allocAligned(sizeof(kiss_fft_cpx)*ZOOM_FFT_SIZE);
+    zoomOut = (kiss_fft_cpx*)allocAligned(sizeof(kiss_fft_cpx)*ZOOM_FFT_SIZE);
+    peakPicker = new SpectralPeakPicker(coarseSize/2 + 1);
+    harmonics = new HarmonicAnalyser(sampleRate, coarseSize);
+
+    windowSum = 0;
+    for (size_t i = 0; i < coarseSize; i++)
+        windowSum += window[i];
+}
+
+ZoomFftDetector::~ZoomFftDetector() {
+    delete fftWorkspace;
+    freeAligned(zoomIn);
+    freeAligned(zoomOut);
+    delete peakPicker;
+    delete harmonics;
+}
+
+bool ZoomFftDetector::detect(const RingBuffer<short>* samples, PitchEstimate* estimate) {
+    kiss_fft_scalar* timeData = fftWorkspace->timeData();
+    kiss_fft_cpx* freqData = fftWorkspace->freqData();
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    RingBuffer<short>::Span first, second;
+    samples->latest(coarseSize, &first, &second);
+    windowSamples(first.data, window, timeData, first.size);
+    windowSamples(second.data, &window[first.size], &timeData[first.size], second.size);
+    coarsePlan->forward(timeData, freqData, fftWorkspace->scratch());
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    float fftSeconds = float(t1.tv_sec - t0.tv_sec) + float(t1.tv_nsec - t0.tv_nsec)/1000000000;
+
+    // The forward FFT only reads timeData, so it still holds the windowed frame for the
+    // zoom stage
+    size_t minBin = size_t(ZOOM_MIN_FREQ*coarseSize/sampleRate) + 1;
+    SpectralPeak peak;
+    if (peakPicker->find(freqData, minBin, coarseSize/2, &peak, 1) == 0)
+        return false;
+
+    float amplitude = 2*sqrt(peak.power)/windowSum;
+    if (amplitude < ZOOM_MIN_AMPLITUDE)
+        return false;
+
+    float coarseBin = peak.bin + logParabolicOffset(peak.powerL, peak.power, peak.powerR);
+    float coarseFreq = coarseBin*sampleRate/coarseSize;
+
+    estimate->overtone = 1;
+#ifdef DETECT_OVERTONES
+    harmonics->setBudget(HARMONIC_BUDGET*fftSeconds);
+    estimate->overtone = harmonics->harmonicOf(peakPicker->power(), coarseFreq);
+#endif
+    estimate->frequency = refineFrequency(coarseFreq);
+    estimate->amplitude = amplitude;
+    return true;
+}
+
+float ZoomFftDetector::refineFrequency(float coarseFreq) {
+    const kiss_fft_scalar* frame = fftWorkspace->timeData();
+
+    // Search a semitone either side of the coarse estimate. Decimate as far as possible
+    // while keeping the decimated band several times wider than the search range.
+    float searchRange = coarseFreq*(pow(2.0f, 1.0f/12) - 1);
+    size_t decimation = 1;
+    while (decimation*2 <= coarseSize/64 && sampleRate/(decimation*2.0f) >= 8*searchRange)
+        decimation *= 2;
+    size_t decimatedSize = coarseSize/decimation - 1;
+    if (decimatedSize > ZOOM_FFT_SIZE)
+        decimatedSize = ZOOM_FFT_SIZE;
+
+    // Mix down by the coarse frequency. Each output sample is a triangle-weighted sum of
+    // 2*decimation input samples, i.e. two cascaded moving averages, which keeps aliases
+    // of the other partials well below the peak.
+    double step = -2*M_PI*coarseFreq/sampleRate;
+    double rotR = cos(step);
+    double rotI = sin(step);
+    memset(zoomIn, 0, sizeof(kiss_fft_cpx)*ZOOM_FFT_SIZE);
+    for (size_t m = 0; m < decimatedSize; m++) {
+        size_t start = m*decimation;
+        double phase = step*start;
+        double pR = cos(phase);
+        double pI = sin(phase);
+        double sumR = 0;
+        double sumI = 0;
+        for (size_t j = 0; j < 2*decimation; j++) {
+            double weight = j < decimation ? j + 1 : 2*decimation - j;
+            double x = frame[start + j]*weight;
+            sumR += x*pR;
+            sumI += x*pI;
+            double t = pR*rotR - pI*rotI;
+            pI = pR*rotI + pI*rotR;
+            pR = t;
+        }
+        zoomIn[m].r = sumR;
+        zoomIn[m].i = sumI;
+    }
+
+    kiss_fft(zoomPlan, zoomIn, zoomOut);
+
+    // Bins are offsets from the coarse frequency, negative ones in the upper half
+    float binWidth = float(sampleRate)/decimation/ZOOM_FFT_SIZE;
+    int range = int(searchRange/binWidth) + 1;
+    if (range > ZOOM_FFT_SIZE/2 - 2)
+        range = ZOOM_FFT_SIZE/2 - 2;
+    int best = 0;
+    float bestPower = -1;
+    float power[3] = { 0, 0, 0 };
+    for (int j = -range; j <= range; j++) {
+        kiss_fft_cpx c = zoomOut[(j + ZOOM_FFT_SIZE) % ZOOM_FFT_SIZE];
+        float p = c.r*c.r + c.i*c.i;
+        if (p > bestPower) {
+            bestPower = p;
+            best = j;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        kiss_fft_cpx c = zoomOut[(best - 1 + i + ZOOM_FFT_SIZE) % ZOOM_FFT_SIZE];
+        power[i] = c.r*c.r + c.i*c.i;
+    }
+
+    return coarseFreq + (best + logParabolicOffset(power[0], power[1], power[2]))*binWidth;
+}
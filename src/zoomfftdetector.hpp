@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2016-2017 Theodore Opeiko
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZoomFftDetector_HPP_
+#define ZoomFftDetector_HPP_
+
+#include "kiss_fft.h"
+#include "fftplancache.hpp"
+#include "harmonicanalyser.hpp"
+#include "pitchdetector.hpp"
+#include "spectralpeaks.hpp"
+#include "windowing.hpp"
+
+#define ZOOM_COARSE_SIZE 8192
+#define ZOOM_FFT_SIZE 4096
+// Lowest frequency the coarse stage looks at
+#define ZOOM_MIN_FREQ 20.0f
+// Coarse peaks weaker than this (sine amplitude in S16 sample units) count as silence
+#define ZOOM_MIN_AMPLITUDE 20.0f
+
+/*
+ * Two-stage estimator. A small FFT finds the dominant peak, then a zoom FFT refines it
+ * within a semitone either side. The zoom stage shifts the windowed frame so the coarse
+ * peak sits at 0 Hz, low-pass filters and decimates it with a triangular kernel, and
+ * zero-pads the few remaining samples into a complex FFT. At the default sizes that
+ * resolves about a cent per bin, interpolated to well below that, for a small fraction
+ * of the cost of a 128K-point FFT over the whole band.
+ */
+class ZoomFftDetector : public PitchDetector {
+public:
+    ZoomFftDetector(int sampleRate, size_t frameSize = ZOOM_COARSE_SIZE);
+    virtual ~ZoomFftDetector();
+
+    virtual const char* name() const { return "zoom"; }
+    virtual size_t frameSize() const { return coarseSize; }
+    virtual bool detect(const RingBuffer<short>* samples, PitchEstimate* estimate);
+
+private:
+    ZoomFftDetector(const ZoomFftDetector&);
+    ZoomFftDetector& operator=(const ZoomFftDetector&);
+
+    float refineFrequency(float coarseFreq);
+
+    int sampleRate;
+    size_t coarseSize;
+    const FftPlan* coarsePlan;
+    kiss_fft_cfg zoomPlan;
+    FftWorkspace* fftWorkspace;
+    const float* window;
+    float windowSum;
+    WindowKernel windowSamples;
+    kiss_fft_cpx* zoomIn;
+    kiss_fft_cpx* zoomOut;
+    SpectralPeakPicker* peakPicker;
+    HarmonicAnalyser* harmonics;
+};
+
+#endif /* ZoomFftDetector_HPP_ */